@@ -6,18 +6,30 @@
 #include <span>
 // #include <hv/HttpService.h>
 #include <hv/HttpServer.h>
+#include <hv/WebSocketServer.h>
+#include <hv/hasync.h>
 #include <turbobase64/turbob64.h>
 #include <ylt/struct_json/json_reader.h>
 #include <ylt/struct_json/json_writer.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
 #include <magic_enum.hpp>
+#include <mutex>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <shared_mutex>
+#include <tuple>
 
+#include "HugePage.h"
 #include "IOUtil.h"
 #include "Infer.h"
+#include "LocalTransport.h"
 #include "Logger.h"
+#include "Metrics.h"
+#include "ResultCache.h"
 #include "VisionSimpleConfig.h"
 #define LOG_DOMAIN_NAME "HTTPServer"
 
@@ -56,15 +68,300 @@ struct InferOCRResponse {
   NLOHMANN_DEFINE_TYPE_INTRUSIVE(InferOCRResponse, results)
 };
 
+// bbox: x, y, width, height
+struct InferOCRDetectResponse {
+  std::vector<std::vector<std::array<int, 4>>> results;
+};
+
+struct OCRRecognizeImage {
+  std::string image;
+  std::vector<std::array<int, 4>> boxes;
+};
+
+struct InferOCRRecognizeRequest {
+  std::string model;
+  std::vector<OCRRecognizeImage> images;
+};
+
+constexpr float INFER_CONFIDENCE_THRESHOLD = 0.125f;
+// websocket stream: the first text message binds the connection to a model,
+// every following binary message is one encoded frame
+constexpr std::string_view STREAM_PATH{"/v0/stream"};
+// detections whose IOU with the previous frame exceeds this are "unchanged"
+constexpr float STREAM_DELTA_IOU = 0.9f;
+
+struct StreamBindRequest {
+  std::string task;
+  std::string model;
+  float confidence;
+  bool delta;
+};
+
+struct StreamBindResponse {
+  std::string task;
+  std::string model;
+  bool delta;
+  std::vector<std::string_view> class_names;
+};
+
+struct StreamYOLOMessage {
+  uint64_t frame;
+  uint64_t dropped;
+  bool delta;
+  std::vector<YOLODetectedObject> results;
+  std::vector<YOLODetectedObject> removed;
+};
+
+struct StreamOCRMessage {
+  uint64_t frame;
+  uint64_t dropped;
+  bool delta;
+  std::vector<OCRLine> results;
+  std::vector<OCRLine> removed;
+};
+
+// /v0/admin/profile: load a separate profiling instance of the model and run
+// it over the given images for `runs` runs and/or `duration_ms`
+struct ProfileRequest {
+  std::string task;
+  std::string model;
+  std::vector<std::string> images;
+  uint32_t runs{0};
+  uint32_t duration_ms{0};
+  // session overrides for the profiling instance, e.g. intra_op_threads
+  std::map<std::string, std::string> session;
+};
+
+struct ProfileResponse {
+  std::string task;
+  std::string model;
+  uint32_t runs;
+  double elapsed_ms;
+  std::vector<std::string> files;
+  std::vector<InferProfileOp> ops;
+};
+
+constexpr uint32_t PROFILE_MAX_RUNS = 10000;
+constexpr uint32_t PROFILE_MAX_DURATION_MS = 10 * 60 * 1000;
+
+enum class StreamTask : uint8_t { kYOLO, kOCR };
+
+struct StreamSession {
+  StreamTask task{StreamTask::kYOLO};
+  InferYOLO* yolo{nullptr};
+  InferOCR* ocr{nullptr};
+  float confidence{0.125f};
+  bool delta{false};
+  MetricSeries series{0};
+  // guarded by mutex: the newest frame that has not been inferred yet
+  std::mutex mutex;
+  std::string pending_frame;
+  bool has_pending{false};
+  bool running{false};
+  uint64_t received{0};
+  uint64_t dropped{0};
+  // owned by the running worker
+  std::string frame;
+  cv::Mat image;
+  std::string message;
+  std::vector<YOLOResult> yolo_view;
+  std::vector<OCRResult> ocr_view;
+};
+
+namespace {
+double RectIOU(const cv::Rect& a, const cv::Rect& b) noexcept {
+  const double intersection = (a & b).area();
+  const double union_area = a.area() + b.area() - intersection;
+  return union_area > 0 ? intersection / union_area : 0.0;
+}
+
+bool SameResult(const YOLOResult& a, const YOLOResult& b) noexcept {
+  return a.class_id == b.class_id &&
+         RectIOU(a.bbox, b.bbox) >= STREAM_DELTA_IOU;
+}
+
+bool SameResult(const OCRResult& a, const OCRResult& b) noexcept {
+  return a.line == b.line && RectIOU(a.rect, b.rect) >= STREAM_DELTA_IOU;
+}
+
+/**
+ * 计算当前帧相对客户端视图的增量，并把视图更新为当前帧
+ * @param view 客户端当前持有的结果
+ * @param current 当前帧结果
+ * @param added 新出现或发生变化的结果
+ * @param removed 从视图中消失的结果
+ */
+template <typename T>
+void DiffResults(std::vector<T>& view, std::vector<T>& current,
+                 std::vector<T>& added, std::vector<T>& removed) {
+  std::vector<bool> matched(view.size(), false);
+  for (auto& item : current) {
+    bool found = false;
+    for (size_t i = 0; i < view.size(); ++i) {
+      if (!matched[i] && SameResult(view[i], item)) {
+        matched[i] = found = true;
+        break;
+      }
+    }
+    if (!found) added.emplace_back(std::move(item));
+  }
+  std::vector<T> next_view;
+  next_view.reserve(view.size() + added.size());
+  for (size_t i = 0; i < view.size(); ++i) {
+    if (matched[i])
+      next_view.emplace_back(std::move(view[i]));
+    else
+      removed.emplace_back(std::move(view[i]));
+  }
+  next_view.insert(next_view.end(), added.begin(), added.end());
+  view = std::move(next_view);
+}
+
+/**
+ * 解码base64编码的图片
+ * @return 解码失败时返回kIOError
+ */
+VSResult<cv::Mat> DecodeBase64Image(const std::string& image_b64) noexcept {
+  auto data_len =
+      tb64declen(reinterpret_cast<const unsigned char*>(image_b64.c_str()),
+                 image_b64.size());
+  std::vector<uint8_t> data_vec(data_len);
+  tb64dec(reinterpret_cast<const unsigned char*>(image_b64.c_str()),
+          image_b64.size(), data_vec.data());
+  try {
+    return cv::imdecode(data_vec, cv::IMREAD_COLOR);
+  } catch (std::exception& e) {
+    return MK_VSERROR(VisionSimpleErrorCode::kIOError, e.what());
+  }
+}
+
+size_t EstimateResultBytes(const YOLOFrameResult& result) noexcept {
+  return sizeof(result) + result.results.size() * sizeof(YOLOResult);
+}
+
+size_t EstimateResultBytes(const OCRFrameResult& result) noexcept {
+  size_t bytes = sizeof(result) + result.results.size() * sizeof(OCRResult);
+  for (const auto& item : result.results) bytes += item.line.capacity();
+  return bytes;
+}
+
+// 一次请求内所有实际计算的图片的耗时累计，缓存命中的图片不计入
+template <typename Timing>
+struct RequestTiming {
+  uint64_t decode_ns{0};
+  uint32_t computed{0};
+  Timing run{};
+};
+
+void AddRunTiming(YOLORunTiming& total, const YOLORunTiming& timing) noexcept {
+  total.preprocess_ns += timing.preprocess_ns;
+  total.session_run_ns += timing.session_run_ns;
+  total.output_convert_ns += timing.output_convert_ns;
+  total.decode_ns += timing.decode_ns;
+  total.nms_ns += timing.nms_ns;
+}
+
+void AddRunTiming(OCRRunTiming& total, const OCRRunTiming& timing) noexcept {
+  total.det_preprocess_ns += timing.det_preprocess_ns;
+  total.det_run_ns += timing.det_run_ns;
+  total.det_postprocess_ns += timing.det_postprocess_ns;
+  total.rec_preprocess_ns += timing.rec_preprocess_ns;
+  total.rec_run_ns += timing.rec_run_ns;
+  total.rec_postprocess_ns += timing.rec_postprocess_ns;
+  total.rec_count += timing.rec_count;
+}
+
+// Server-Timing的dur单位为毫秒
+double ToMilliseconds(uint64_t nanoseconds) noexcept {
+  return static_cast<double>(nanoseconds) / 1e6;
+}
+
+std::string FormatServerTiming(
+    const RequestTiming<YOLORunTiming>& timing) noexcept {
+  const auto& run = timing.run;
+  return std::format(
+      "image-decode;dur={:.3f}, preprocess;dur={:.3f}, session;dur={:.3f}, "
+      "convert;dur={:.3f}, decode;dur={:.3f}, nms;dur={:.3f}, "
+      "computed;desc=\"{}\"",
+      ToMilliseconds(timing.decode_ns), ToMilliseconds(run.preprocess_ns),
+      ToMilliseconds(run.session_run_ns), ToMilliseconds(run.output_convert_ns),
+      ToMilliseconds(run.decode_ns), ToMilliseconds(run.nms_ns),
+      timing.computed);
+}
+
+std::string FormatServerTiming(
+    const RequestTiming<OCRRunTiming>& timing) noexcept {
+  const auto& run = timing.run;
+  return std::format(
+      "image-decode;dur={:.3f}, det-pre;dur={:.3f}, det-run;dur={:.3f}, "
+      "det-post;dur={:.3f}, rec-pre;dur={:.3f}, rec-run;dur={:.3f};desc=\"{} "
+      "runs\", rec-post;dur={:.3f}, computed;desc=\"{}\"",
+      ToMilliseconds(timing.decode_ns), ToMilliseconds(run.det_preprocess_ns),
+      ToMilliseconds(run.det_run_ns), ToMilliseconds(run.det_postprocess_ns),
+      ToMilliseconds(run.rec_preprocess_ns), ToMilliseconds(run.rec_run_ns),
+      run.rec_count, ToMilliseconds(run.rec_postprocess_ns), timing.computed);
+}
+
+YOLODetectedObject ToDetectedObject(const YOLOResult& result) noexcept {
+  const auto& bbox = result.bbox;
+  return YOLODetectedObject{
+      .class_id = result.class_id,
+      .confidence = result.confidence,
+      .bbox = {bbox.x, bbox.y, bbox.width, bbox.height},
+  };
+}
+
+// models.yaml中模型的session参数，overrides中的同名键优先
+InferArgs SessionArgs(const std::map<std::string, std::string>& session,
+                      const InferArgs& overrides) {
+  InferArgs args{overrides};
+  args.insert(session.begin(), session.end());
+  return args;
+}
+
+// 全局线程池开启时session不再创建自己的线程池，models.yaml中的线程参数不生效
+void WarnIgnoredSessionThreads() {
+  auto config_result = Config::Instance();
+  if (!config_result) return;
+  const auto& model_config = config_result->get().model_config();
+  const auto warn = [](const std::string& name,
+                       const std::map<std::string, std::string>& session) {
+    for (auto key : {INFER_ARG_KEY_INTRA_OP_THREADS,
+                     INFER_ARG_KEY_INTER_OP_THREADS,
+                     INFER_ARG_KEY_ALLOW_SPINNING})
+      if (session.contains(std::string(key)))
+        Logger::Instance()->get().Warn(
+            LOG_DOMAIN_NAME,
+            std::format("model {}: {} is ignored while {} is enabled", name,
+                        key, HTTPSERVER_OPT_KEY_INFER_GLOBAL_THREAD_POOLS));
+  };
+  for (const auto& info : model_config.yolo) warn(info.name, info.session);
+  for (const auto& info : model_config.ocr) warn(info.name, info.session);
+}
+
+OCRLine ToOCRLine(const OCRResult& result) {
+  const auto& rect = result.rect;
+  return OCRLine{result.line,
+                 result.confidence,
+                 {rect.x, rect.y, rect.width, rect.height}};
+}
+}  // namespace
+
 class HTTPServerImpl : public HTTPServer {
   HTTPServerOptions options_;
   hv::HttpService http_service_;
+  hv::WebSocketService ws_service_;
   hv::HttpServer http_server_;
   std::unique_ptr<InferContext> infer_context_;
+  std::unique_ptr<LocalTransport> local_transport_;
+  std::unique_ptr<ResultCache<YOLOFrameResult>> yolo_result_cache_;
+  std::unique_ptr<ResultCache<OCRFrameResult>> ocr_result_cache_;
   std::shared_mutex yolo_models_cache_mutex_;
   std::map<std::string, std::unique_ptr<InferYOLO>> yolo_models_cache_;
   std::shared_mutex ocr_models_cache_mutex_;
   std::map<std::string, std::unique_ptr<InferOCR>> ocr_models_cache_;
+  // 正在运行/v0/admin/profile
+  std::atomic<bool> profiling_{false};
 
   std::expected<std::reference_wrapper<InferYOLO>, VisionSimpleError>
   GetYOLOModel(const std::string& name) {
@@ -77,7 +374,19 @@ class HTTPServerImpl : public HTTPServer {
     std::unique_lock lock{yolo_models_cache_mutex_};
     if (auto it = yolo_models_cache_.find(name); it != yolo_models_cache_.end())
       return *it->second;
-    // load model
+    auto model = LoadYOLOModel(name);
+    if (!model) return std::unexpected(std::move(model.error()));
+    auto& model_ref = *yolo_models_cache_.emplace(name, std::move(*model))
+                           .first->second;
+    return model_ref;
+  }
+
+  /**
+   * 按models.yaml创建YOLO模型，不放入缓存
+   * @param session_overrides 覆盖配置中的session参数
+   */
+  VSResult<std::unique_ptr<InferYOLO>> LoadYOLOModel(
+      const std::string& name, const InferArgs& session_overrides = {}) {
     auto config_result = Config::Instance();
     if (!config_result)
       return std::unexpected(std::move(config_result.error()));
@@ -93,7 +402,7 @@ class HTTPServerImpl : public HTTPServer {
             VisionSimpleErrorCode::kModelError,
             std::format("unknown yolo version: {}", model_info.version)}};
       auto version = *version_opt;
-      auto data_result = ReadAll(model_info.path);
+      auto data_result = MappedFile::Open(model_info.path);
       if (!data_result)
         return std::unexpected{
             VisionSimpleError{VisionSimpleErrorCode::kIOError,
@@ -109,15 +418,15 @@ class HTTPServerImpl : public HTTPServer {
                               "device_id is not a integer: " + device_str}};
       }
       auto infer_yolo_result = InferYOLO::Create(
-          *infer_context_, data_result->span(), version, device_id);
+          *infer_context_, data_result->span(), version, device_id,
+          SessionArgs(model_info.session, session_overrides));
       if (!infer_yolo_result) {
         return std::unexpected{VisionSimpleError{
             VisionSimpleErrorCode::kModelError,
             std::format("unable to create infer yolo model:{},message:{} ",
                         name, infer_yolo_result.error().message)}};
       }
-      yolo_models_cache_.emplace(name, std::move(*infer_yolo_result));
-      return *yolo_models_cache_[name];
+      return std::move(*infer_yolo_result);
     }
     return MK_VSERROR(VisionSimpleErrorCode::kModelError,
                       "unable to find model: " + name);
@@ -133,6 +442,19 @@ class HTTPServerImpl : public HTTPServer {
     std::unique_lock lock{ocr_models_cache_mutex_};
     if (auto it = ocr_models_cache_.find(name); it != ocr_models_cache_.end())
       return *it->second;
+    auto model = LoadOCRModel(name);
+    if (!model) return std::unexpected(std::move(model.error()));
+    auto& model_ref = *ocr_models_cache_.emplace(name, std::move(*model))
+                           .first->second;
+    return model_ref;
+  }
+
+  /**
+   * 按models.yaml创建OCR模型，不放入缓存
+   * @param session_overrides 覆盖配置中的session参数
+   */
+  VSResult<std::unique_ptr<InferOCR>> LoadOCRModel(
+      const std::string& name, const InferArgs& session_overrides = {}) {
     auto config_result = Config::Instance();
     if (!config_result)
       return std::unexpected(std::move(config_result.error()));
@@ -159,17 +481,33 @@ class HTTPServerImpl : public HTTPServer {
             VisionSimpleError{VisionSimpleErrorCode::kParameterError,
                               "device_id is not a integer: " + device_str}};
       }
+      auto limit_type_opt =
+          magic_enum::enum_cast<OCRDetLimitType>(model_info.det_limit_type);
+      if (!limit_type_opt)
+        return MK_VSERROR(VisionSimpleErrorCode::kParameterError,
+                          std::format("unknown det_limit_type:{}",
+                                      model_info.det_limit_type));
+      const OCROptions ocr_options{
+          .rec_batch_size = model_info.rec_batch_size,
+          .rec_threads = model_info.rec_threads,
+          .rec_max_width = model_info.rec_max_width,
+          .rec_cache_entries = model_info.rec_cache_entries,
+          .det_threshold = model_info.det_threshold,
+          .det_box_threshold = model_info.det_box_threshold,
+          .det_limit_side_len = model_info.det_limit_side_len,
+          .det_limit_type = *limit_type_opt,
+          .det_batch_size = model_info.det_batch_size,
+          .session_args = SessionArgs(model_info.session, session_overrides)};
       auto infer_ocr_result = InferOCR::Create(
           *infer_context_, model_info.char_dict_path, model_info.det_path,
-          model_info.rec_path, model_type, device_id);
+          model_info.rec_path, model_type, device_id, ocr_options);
       if (!infer_ocr_result) {
         return std::unexpected{VisionSimpleError{
             VisionSimpleErrorCode::kModelError,
             std::format("unable to create infer ocr model:{},message:{} ", name,
                         infer_ocr_result.error().message)}};
       }
-      ocr_models_cache_.emplace(name, std::move(*infer_ocr_result));
-      return *ocr_models_cache_[name];
+      return std::move(*infer_ocr_result);
     }
     return MK_VSERROR(VisionSimpleErrorCode::kModelError,
                       "unable to find model: " + name);
@@ -198,10 +536,33 @@ public:
     http_service_.POST("/v0/infer/ocr", [this](const HttpContextPtr& ctx) {
       return this->HandleInferOCR(ctx);
     });
+    // /v0/infer/ocr/detect
+    http_service_.POST("/v0/infer/ocr/detect",
+                       [this](const HttpContextPtr& ctx) {
+                         return this->HandleInferOCRDetect(ctx);
+                       });
+    // /v0/infer/ocr/recognize
+    http_service_.POST("/v0/infer/ocr/recognize",
+                       [this](const HttpContextPtr& ctx) {
+                         return this->HandleInferOCRRecognize(ctx);
+                       });
     // /v0/infer/models
     http_service_.GET("/v0/infer/models", [this](const HttpContextPtr& ctx) {
       return this->HandleInferModels(ctx);
     });
+    // /metrics
+    http_service_.GET("/metrics", [](const HttpContextPtr& ctx) {
+      ctx->sendString(Metrics::Instance().Render());
+      return 200;
+    });
+    // /v0/cache/stats
+    http_service_.GET("/v0/cache/stats", [this](const HttpContextPtr& ctx) {
+      return this->HandleCacheStats(ctx);
+    });
+    // /v0/admin/profile
+    http_service_.POST("/v0/admin/profile", [this](const HttpContextPtr& ctx) {
+      return this->HandleProfile(ctx);
+    });
     http_service_.Use([](const HttpContextPtr& ctx) {
       Logger::Instance()->get().Info(LOG_DOMAIN_NAME,
                                      std::format("{}:{} -> {}", ctx->ip(),
@@ -210,9 +571,22 @@ public:
     });
     http_service_.AllowCORS();
     http_service_.enable_access_log = 0;
+    // /v0/stream
+    ws_service_.onopen = [this](const WebSocketChannelPtr& channel,
+                                const HttpRequestPtr& req) {
+      this->HandleStreamOpen(channel, req);
+    };
+    ws_service_.onmessage = [this](const WebSocketChannelPtr& channel,
+                                   const std::string& msg) {
+      this->HandleStreamMessage(channel, msg);
+    };
+    ws_service_.onclose = [](const WebSocketChannelPtr& channel) {
+      channel->deleteContextPtr();
+    };
 
     http_server_.port = options_.port;
     http_server_.service = &http_service_;
+    http_server_.ws = &ws_service_;
     logger_set_handler(hv_default_logger(),
                        [](int log_level, const char* buf, int
                           len) {
@@ -246,15 +620,223 @@ public:
                        });
   }
 
+  ~HTTPServerImpl() override {
+    // 连接线程使用模型缓存中的模型，需在缓存析构前停止
+    if (local_transport_) local_transport_->Stop();
+    Metrics::Instance().RemoveGauges(this);
+  }
+
   const HTTPServerOptions& options() const noexcept override {
     return options_;
   }
 
-  void Run() noexcept override { http_server_run(&http_server_); }
+  HTTPServerResult<void> SetupLocalTransport() {
+    const auto& socket_path =
+        options_.OptionOrPut(HTTPSERVER_OPT_KEY_LOCAL_IPC_PATH,
+                             HTTPSERVER_OPT_DEFVAL_LOCAL_IPC_PATH);
+    if (socket_path.empty()) return {};
+    LocalTransportOptions transport_options;
+    transport_options.socket_path = socket_path;
+    transport_options.shm_name =
+        options_.OptionOrPut(HTTPSERVER_OPT_KEY_LOCAL_IPC_SHM_NAME,
+                             HTTPSERVER_OPT_DEFVAL_LOCAL_IPC_SHM_NAME);
+    try {
+      transport_options.slot_count = static_cast<uint32_t>(
+          std::stoul(options_.OptionOrPut(HTTPSERVER_OPT_KEY_LOCAL_IPC_SLOTS,
+                                          HTTPSERVER_OPT_DEFVAL_LOCAL_IPC_SLOTS)));
+      transport_options.client_slots =
+          static_cast<uint32_t>(std::stoul(options_.OptionOrPut(
+              HTTPSERVER_OPT_KEY_LOCAL_IPC_CLIENT_SLOTS,
+              HTTPSERVER_OPT_DEFVAL_LOCAL_IPC_CLIENT_SLOTS)));
+      transport_options.frame_slot_bytes = std::stoull(options_.OptionOrPut(
+          HTTPSERVER_OPT_KEY_LOCAL_IPC_FRAME_BYTES,
+          HTTPSERVER_OPT_DEFVAL_LOCAL_IPC_FRAME_BYTES));
+      transport_options.result_slot_bytes = std::stoull(options_.OptionOrPut(
+          HTTPSERVER_OPT_KEY_LOCAL_IPC_RESULT_BYTES,
+          HTTPSERVER_OPT_DEFVAL_LOCAL_IPC_RESULT_BYTES));
+    } catch (std::exception& e) {
+      return MK_VSERROR(
+          VisionSimpleErrorCode::kParameterError,
+          std::format("invalid local transport options:{}", e.what()));
+    }
+    auto transport_result = LocalTransport::Create(
+        std::move(transport_options),
+        [this](const std::string& name) { return GetYOLOModel(name); },
+        [this](const std::string& name) { return GetOCRModel(name); });
+    if (!transport_result)
+      return std::unexpected(std::move(transport_result.error()));
+    local_transport_ = std::move(*transport_result);
+    return {};
+  }
 
-  void StartAsync() noexcept override { http_server_run(&http_server_, 0); }
+  /**
+   * 启动时加载开启了autotune的模型，调优在开始监听前完成，
+   * 不会在请求中持有模型缓存的锁时进行
+   */
+  void PreloadAutoTunedModels() {
+    if (infer_context_->execution_provider() != InferEP::kCPU) return;
+    auto config_result = Config::Instance();
+    if (!config_result) return;
+    const auto& model_config = config_result->get().model_config();
+    const auto& context_autotune = options_.OptionOrPut(
+        HTTPSERVER_OPT_KEY_INFER_AUTOTUNE, HTTPSERVER_OPT_DEFVAL_INFER_AUTOTUNE);
+    const auto autotuned =
+        [&context_autotune](const std::map<std::string, std::string>& session) {
+          auto it = session.find(std::string(INFER_ARG_KEY_AUTOTUNE));
+          const auto& value =
+              it != session.end() ? it->second : context_autotune;
+          return !value.empty() &&
+                 value != magic_enum::enum_name(InferAutoTune::kOff);
+        };
+    auto& logger = Logger::Instance()->get();
+    for (const auto& info : model_config.yolo) {
+      if (!autotuned(info.session)) continue;
+      logger.Info(LOG_DOMAIN_NAME,
+                  std::format("autotuning yolo model {}", info.name));
+      if (auto result = GetYOLOModel(info.name); !result)
+        logger.Warn(LOG_DOMAIN_NAME,
+                    std::format("unable to preload yolo model {}:{}",
+                                info.name, result.error().message));
+    }
+    for (const auto& info : model_config.ocr) {
+      if (!autotuned(info.session)) continue;
+      logger.Info(LOG_DOMAIN_NAME,
+                  std::format("autotuning ocr model {}", info.name));
+      if (auto result = GetOCRModel(info.name); !result)
+        logger.Warn(LOG_DOMAIN_NAME,
+                    std::format("unable to preload ocr model {}:{}",
+                                info.name, result.error().message));
+    }
+  }
+
+  // gauge捕获this，由析构函数移除
+  void RegisterGauges() {
+    auto& metrics = Metrics::Instance();
+    metrics.AddGauge(
+        "vision_simple_loaded_models", "Models loaded in memory.",
+        R"(task="yolo")",
+        [this] {
+          std::shared_lock lock{yolo_models_cache_mutex_};
+          return static_cast<double>(yolo_models_cache_.size());
+        },
+        this);
+    metrics.AddGauge(
+        "vision_simple_loaded_models", "Models loaded in memory.",
+        R"(task="ocr")",
+        [this] {
+          std::shared_lock lock{ocr_models_cache_mutex_};
+          return static_cast<double>(ocr_models_cache_.size());
+        },
+        this);
+    const auto rec_cache_stat = [this](uint64_t OCRRecCacheStats::* field) {
+      return [this, field] {
+        std::shared_lock lock{ocr_models_cache_mutex_};
+        uint64_t total = 0;
+        for (const auto& [_, model] : ocr_models_cache_)
+          total += model->rec_cache_stats().*field;
+        return static_cast<double>(total);
+      };
+    };
+    metrics.AddCounter("vision_simple_ocr_rec_cache_lookups_total",
+                       "OCR rec cache lookups per text segment.",
+                       R"(result="hit")",
+                       rec_cache_stat(&OCRRecCacheStats::hits), this);
+    metrics.AddCounter("vision_simple_ocr_rec_cache_lookups_total",
+                       "OCR rec cache lookups per text segment.",
+                       R"(result="miss")",
+                       rec_cache_stat(&OCRRecCacheStats::misses), this);
+    metrics.AddGauge("vision_simple_ocr_rec_cache_entries",
+                     "Entries in the OCR rec caches.", "",
+                     rec_cache_stat(&OCRRecCacheStats::entries), this);
+    metrics.AddGauge(
+        "vision_simple_huge_page_bytes", "Memory mapped by the huge page pool.",
+        R"(state="mapped")",
+        [] {
+          return static_cast<double>(
+              HugePagePool::Instance().stats().mapped_bytes);
+        },
+        this);
+    metrics.AddGauge(
+        "vision_simple_huge_page_bytes", "Memory mapped by the huge page pool.",
+        R"(state="cached")",
+        [] {
+          return static_cast<double>(
+              HugePagePool::Instance().stats().cached_bytes);
+        },
+        this);
+    if (!yolo_result_cache_ || !ocr_result_cache_) return;
+    metrics.AddGauge(
+        "vision_simple_result_cache_bytes", "Estimated result cache memory.",
+        R"(task="yolo")",
+        [this] { return static_cast<double>(yolo_result_cache_->stats().bytes); },
+        this);
+    metrics.AddGauge(
+        "vision_simple_result_cache_bytes", "Estimated result cache memory.",
+        R"(task="ocr")",
+        [this] { return static_cast<double>(ocr_result_cache_->stats().bytes); },
+        this);
+    metrics.AddGauge(
+        "vision_simple_result_cache_entries", "Entries in the result cache.",
+        R"(task="yolo")",
+        [this] {
+          return static_cast<double>(yolo_result_cache_->stats().entries);
+        },
+        this);
+    metrics.AddGauge(
+        "vision_simple_result_cache_entries", "Entries in the result cache.",
+        R"(task="ocr")",
+        [this] {
+          return static_cast<double>(ocr_result_cache_->stats().entries);
+        },
+        this);
+  }
 
-  void Stop() noexcept override { http_server_.stop(); }
+  HTTPServerResult<void> SetupResultCache() {
+    size_t max_entries{0}, max_bytes{0};
+    try {
+      max_entries = std::stoull(
+          options_.OptionOrPut(HTTPSERVER_OPT_KEY_RESULT_CACHE_ENTRIES,
+                               HTTPSERVER_OPT_DEFVAL_RESULT_CACHE_ENTRIES));
+      max_bytes = std::stoull(
+          options_.OptionOrPut(HTTPSERVER_OPT_KEY_RESULT_CACHE_BYTES,
+                               HTTPSERVER_OPT_DEFVAL_RESULT_CACHE_BYTES));
+    } catch (std::exception& e) {
+      return MK_VSERROR(
+          VisionSimpleErrorCode::kParameterError,
+          std::format("invalid result cache options:{}", e.what()));
+    }
+    if (max_entries == 0 || max_bytes == 0) return {};
+    auto yolo_size_of = [](const YOLOFrameResult& result) {
+      return EstimateResultBytes(result);
+    };
+    auto ocr_size_of = [](const OCRFrameResult& result) {
+      return EstimateResultBytes(result);
+    };
+    yolo_result_cache_ = std::make_unique<ResultCache<YOLOFrameResult>>(
+        max_entries, max_bytes, yolo_size_of);
+    ocr_result_cache_ = std::make_unique<ResultCache<OCRFrameResult>>(
+        max_entries, max_bytes, ocr_size_of);
+    Logger::Instance()->get().Info(
+        LOG_DOMAIN_NAME,
+        std::format("result cache enabled, entries:{} bytes:{}", max_entries,
+                    max_bytes));
+    return {};
+  }
+
+  void Run() noexcept override {
+    if (local_transport_) local_transport_->StartAsync();
+    http_server_run(&http_server_);
+  }
+
+  void StartAsync() noexcept override {
+    if (local_transport_) local_transport_->StartAsync();
+    http_server_run(&http_server_, 0);
+  }
+
+  void Stop() noexcept override {
+    http_server_.stop();
+    if (local_transport_) local_transport_->Stop();
+  }
 
   int HandleInferModels(const HttpContextPtr& ctx) noexcept {
     auto config_result = Config::Instance();
@@ -284,45 +866,206 @@ public:
     return 200;
   }
 
+  int HandleCacheStats(const HttpContextPtr& ctx) noexcept {
+    std::map<std::string_view, ResultCacheStats> stats;
+    if (yolo_result_cache_) stats.emplace("yolo", yolo_result_cache_->stats());
+    if (ocr_result_cache_) stats.emplace("ocr", ocr_result_cache_->stats());
+    std::string json_str;
+    struct_json::to_json(stats, json_str);
+    ctx->send(json_str, APPLICATION_JSON);
+    return 200;
+  }
+
+  int HandleProfile(const HttpContextPtr& ctx) noexcept {
+    const auto profile_dir = options_.OptionOrPut(
+        HTTPSERVER_OPT_KEY_PROFILE_DIR, HTTPSERVER_OPT_DEFVAL_PROFILE_DIR);
+    if (profile_dir.empty()) {
+      ctx->sendString("profiling is disabled, set profile_dir to enable it");
+      return 403;
+    }
+    ProfileRequest request;
+    std::error_code error_code;
+    struct_json::from_json(request, ctx->body(), error_code);
+    if (error_code) {
+      ctx->sendString(error_code.message());
+      return 400;
+    }
+    if (request.images.empty() ||
+        (request.runs == 0 && request.duration_ms == 0) ||
+        request.runs > PROFILE_MAX_RUNS ||
+        request.duration_ms > PROFILE_MAX_DURATION_MS) {
+      ctx->sendString(std::format(
+          "images and runs(<={}) or duration_ms(<={}) are required",
+          PROFILE_MAX_RUNS, PROFILE_MAX_DURATION_MS));
+      return 400;
+    }
+    std::vector<cv::Mat> images;
+    images.reserve(request.images.size());
+    for (const auto& image_b64 : request.images) {
+      auto image = DecodeBase64Image(image_b64);
+      if (!image || image->empty()) {
+        ctx->sendString("unable to decode image");
+        return 400;
+      }
+      images.emplace_back(*std::move(image));
+    }
+    std::error_code fs_error;
+    std::filesystem::create_directories(profile_dir, fs_error);
+    if (fs_error) {
+      ctx->sendString(std::format("unable to create profile_dir {}:{}",
+                                  profile_dir, fs_error.message()));
+      return 500;
+    }
+    InferArgs overrides{request.session.begin(), request.session.end()};
+    overrides[std::string{INFER_ARG_KEY_PROFILE_PREFIX}] =
+        (std::filesystem::path(profile_dir) /
+         std::format("{}_{}", request.task, request.model))
+            .string();
+    // 同一时刻只分析一个模型，避免分析之间互相抢占CPU
+    if (profiling_.exchange(true)) {
+      ctx->sendString("another profile is running");
+      return 409;
+    }
+    // 分析最长持续PROFILE_MAX_DURATION_MS，不能阻塞IO线程，完成后再回复
+    hv::async([this, ctx, request = std::move(request),
+               images = std::move(images),
+               overrides = std::move(overrides)] {
+      std::string body;
+      http_content_type content_type = TEXT_PLAIN;
+      const auto status =
+          RunProfile(request, images, overrides, body, content_type);
+      profiling_.store(false);
+      ctx->setStatus(static_cast<http_status>(status));
+      ctx->send(body, content_type);
+    });
+    return HTTP_STATUS_UNFINISHED;
+  }
+
+  /**
+   * 加载独立的分析实例并运行，在线程池上执行
+   * @param body 响应内容
+   * @return HTTP状态码
+   */
+  int RunProfile(const ProfileRequest& request,
+                 const std::vector<cv::Mat>& images, const InferArgs& overrides,
+                 std::string& body, http_content_type& content_type) noexcept {
+    std::unique_ptr<InferYOLO> yolo;
+    std::unique_ptr<InferOCR> ocr;
+    if (request.task == "yolo") {
+      auto model = LoadYOLOModel(request.model, overrides);
+      if (!model) {
+        body = model.error().message;
+        return 400;
+      }
+      yolo = std::move(*model);
+    } else if (request.task == "ocr") {
+      auto model = LoadOCRModel(request.model, overrides);
+      if (!model) {
+        body = model.error().message;
+        return 400;
+      }
+      ocr = std::move(*model);
+    } else {
+      body = "task must be yolo or ocr";
+      return 400;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::milliseconds(request.duration_ms);
+    uint32_t runs = 0;
+    while ((request.runs == 0 || runs < request.runs) &&
+           (request.duration_ms == 0 ||
+            std::chrono::steady_clock::now() < deadline)) {
+      const auto& image = images[runs % images.size()];
+      const bool ok =
+          yolo ? yolo->Run(image, INFER_CONFIDENCE_THRESHOLD).has_value()
+               : ocr->Run(image, INFER_CONFIDENCE_THRESHOLD).has_value();
+      if (!ok) break;
+      ++runs;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    ProfileResponse response{
+        .task = request.task,
+        .model = request.model,
+        .runs = runs,
+        .elapsed_ms =
+            std::chrono::duration<double, std::milli>(elapsed).count(),
+        .files = yolo ? yolo->EndProfiling() : ocr->EndProfiling()};
+    auto ops = SummarizeInferProfile(response.files);
+    if (!ops) {
+      body = ops.error().message;
+      return 500;
+    }
+    response.ops = std::move(*ops);
+    Logger::Instance()->get().Info(
+        LOG_DOMAIN_NAME,
+        std::format("profiled {}:{} for {} runs, {} op types", request.task,
+                    request.model, runs, response.ops.size()));
+    try {
+      struct_json::to_json(response, body);
+      content_type = APPLICATION_JSON;
+      return 200;
+    } catch (std::exception& e) {
+      body = std::format("unable to serialize:{}", e.what());
+      return 500;
+    }
+  }
+
   int HandleInferYOLO(const HttpContextPtr& ctx) noexcept {
     // ctx->request
     const auto& str = ctx->body();
     InferYOLORequest parsed_request;
     std::error_code error_code;
+    MetricsInFlight in_flight;
+    auto& metrics = Metrics::Instance();
     struct_json::from_json(parsed_request, str, error_code);
     if (error_code) {
+      metrics.CountRequest(metrics.Series("yolo", ""), true);
       ctx->sendString(error_code.message());
       return 400;
     }
+    // 查到模型后才按模型名注册序列，未知模型计入空模型名，避免占满序列表
     auto infer_result = GetYOLOModel(parsed_request.model);
     if (!infer_result) {
+      metrics.CountRequest(metrics.Series("yolo", ""), true);
       ctx->sendString(infer_result.error().message.c_str());
       return 400;
     }
+    const auto series = metrics.Series("yolo", parsed_request.model);
     auto& infer = infer_result->get();
-    std::vector<cv::Mat> images;
-    images.reserve(parsed_request.images.size());
-    for (const auto& image_b64 : parsed_request.images) {
-      auto data_len =
-          tb64declen(reinterpret_cast<const unsigned char*>(image_b64.c_str()),
-                     image_b64.size());
-      std::vector<uint8_t> data_vec(data_len);
-      tb64dec(reinterpret_cast<const unsigned char*>(image_b64.c_str()),
-              image_b64.size(), data_vec.data());
-      try {
-        images.emplace_back(imdecode(data_vec, cv::IMREAD_COLOR));
-      } catch (std::exception& e) {
-        ctx->sendString(e.what());
-        return 400;
-      }
-    }
+    RequestTiming<YOLORunTiming> server_timing;
     std::vector<YOLOFrameResult> all_results;
-    all_results.reserve(images.size());
-    for (const auto& image : images) {
-      if (auto result = infer.Run(image, 0.125)) {
+    all_results.reserve(parsed_request.images.size());
+    for (const auto& image_b64 : parsed_request.images) {
+      auto compute = [&]() -> InferYOLO::RunResult {
+        MetricsTimer timer;
+        auto image = DecodeBase64Image(image_b64);
+        const auto decode_ns = timer.Lap();
+        metrics.ObserveStage(series, MetricStage::kDecode, decode_ns);
+        server_timing.decode_ns += decode_ns;
+        if (!image) return std::unexpected(std::move(image.error()));
+        YOLORunTiming timing;
+        auto result = infer.Run(*image, INFER_CONFIDENCE_THRESHOLD, &timing);
+        metrics.ObserveRun(series, timing);
+        AddRunTiming(server_timing.run, timing);
+        ++server_timing.computed;
+        return result;
+      };
+      auto result = yolo_result_cache_
+                        ? yolo_result_cache_->GetOrCompute(
+                              MakeResultCacheKey("yolo", parsed_request.model,
+                                                 INFER_CONFIDENCE_THRESHOLD,
+                                                 image_b64),
+                              compute)
+                        : compute();
+      if (result) {
         all_results.emplace_back(*std::move(result));
+      } else if (result.error().code == VisionSimpleErrorCode::kIOError) {
+        metrics.CountRequest(series, true);
+        ctx->sendString(result.error().message.c_str());
+        return 400;
       }
     }
+    MetricsTimer serialize_timer;
     InferYOLOResponse response;
     response.class_names = std::vector<std::string_view>(
         infer.class_names().cbegin(), infer.class_names().cend());
@@ -344,12 +1087,17 @@ public:
     try {
       std::string json_str;
       struct_json::to_json(std::move(response), json_str);
+      metrics.ObserveStage(series, MetricStage::kSerialize,
+                           serialize_timer.Lap());
+      metrics.CountRequest(series, false);
+      ctx->setHeader("Server-Timing", FormatServerTiming(server_timing));
       ctx->send(json_str, APPLICATION_JSON);
       //TODO: move to logger thread
       Logger::Instance()->get().Debug(LOG_DOMAIN_NAME,
                                       std::format("{}", json_str));
       return 200;
     } catch (std::exception& e) {
+      metrics.CountRequest(series, true);
       ctx->sendString(std::format("unable to serialize:{}", e.what()));
       return 400;
     }
@@ -359,40 +1107,88 @@ public:
     const auto& str = ctx->body();
     InferOCRRequest parsed_request;
     std::error_code error_code;
+    MetricsInFlight in_flight;
+    auto& metrics = Metrics::Instance();
     struct_json::from_json(parsed_request, str, error_code);
     if (error_code) {
+      metrics.CountRequest(metrics.Series("ocr", ""), true);
       ctx->sendString(error_code.message());
       return 400;
     }
     auto infer_result = GetOCRModel(parsed_request.model);
     if (!infer_result) {
+      metrics.CountRequest(metrics.Series("ocr", ""), true);
       ctx->sendString(infer_result.error().message.c_str());
       return 400;
     }
+    const auto series = metrics.Series("ocr", parsed_request.model);
     auto& infer = infer_result->get();
-    std::vector<cv::Mat> images;
-    images.reserve(parsed_request.images.size());
-    for (const auto& image_b64 : parsed_request.images) {
-      auto data_len =
-          tb64declen(reinterpret_cast<const unsigned char*>(image_b64.c_str()),
-                     image_b64.size());
-      std::vector<uint8_t> data_vec(data_len);
-      tb64dec(reinterpret_cast<const unsigned char*>(image_b64.c_str()),
-              image_b64.size(), data_vec.data());
-      try {
-        images.emplace_back(imdecode(data_vec, cv::IMREAD_COLOR));
-      } catch (std::exception& e) {
-        ctx->sendString(e.what());
-        return 400;
+    RequestTiming<OCRRunTiming> server_timing;
+    std::vector<OCRFrameResult> all_results;
+    all_results.reserve(parsed_request.images.size());
+    if (!ocr_result_cache_ && parsed_request.images.size() > 1) {
+      // 不经过缓存时整批推理，det与rec流水线执行
+      std::vector<cv::Mat> images;
+      images.reserve(parsed_request.images.size());
+      MetricsTimer timer;
+      for (const auto& image_b64 : parsed_request.images) {
+        auto image = DecodeBase64Image(image_b64);
+        if (!image) {
+          metrics.CountRequest(series, true);
+          ctx->sendString(image.error().message.c_str());
+          return 400;
+        }
+        images.emplace_back(std::move(*image));
       }
+      server_timing.decode_ns = timer.Lap();
+      metrics.ObserveStage(series, MetricStage::kDecode,
+                           server_timing.decode_ns);
+      auto results = infer.RunBatch(images, INFER_CONFIDENCE_THRESHOLD,
+                                    &server_timing.run);
+      metrics.ObserveRun(series, server_timing.run);
+      server_timing.computed = static_cast<uint32_t>(images.size());
+      for (auto& result : results)
+        if (result) all_results.emplace_back(*std::move(result));
+      return SendOCRResponse(ctx, series, all_results, server_timing);
     }
-    std::vector<OCRFrameResult> all_results;
-    all_results.reserve(images.size());
-    for (const auto& image : images) {
-      if (auto result = infer.Run(image, 0.125)) {
+    for (const auto& image_b64 : parsed_request.images) {
+      auto compute = [&]() -> InferOCR::RunResult {
+        MetricsTimer timer;
+        auto image = DecodeBase64Image(image_b64);
+        const auto decode_ns = timer.Lap();
+        metrics.ObserveStage(series, MetricStage::kDecode, decode_ns);
+        server_timing.decode_ns += decode_ns;
+        if (!image) return std::unexpected(std::move(image.error()));
+        OCRRunTiming timing;
+        auto result = infer.Run(*image, INFER_CONFIDENCE_THRESHOLD, &timing);
+        metrics.ObserveRun(series, timing);
+        AddRunTiming(server_timing.run, timing);
+        ++server_timing.computed;
+        return result;
+      };
+      auto result = ocr_result_cache_
+                        ? ocr_result_cache_->GetOrCompute(
+                              MakeResultCacheKey("ocr", parsed_request.model,
+                                                 INFER_CONFIDENCE_THRESHOLD,
+                                                 image_b64),
+                              compute)
+                        : compute();
+      if (result) {
         all_results.emplace_back(*std::move(result));
+      } else if (result.error().code == VisionSimpleErrorCode::kIOError) {
+        metrics.CountRequest(series, true);
+        ctx->sendString(result.error().message.c_str());
+        return 400;
       }
     }
+    return SendOCRResponse(ctx, series, all_results, server_timing);
+  }
+
+  int SendOCRResponse(const HttpContextPtr& ctx, MetricSeries series,
+                      std::vector<OCRFrameResult>& all_results,
+                      const RequestTiming<OCRRunTiming>& server_timing) {
+    auto& metrics = Metrics::Instance();
+    MetricsTimer serialize_timer;
     InferOCRResponse response;
     response.results.reserve(all_results.size());
     for (auto& result : all_results) {
@@ -410,16 +1206,321 @@ public:
     try {
       std::string json_str;
       struct_json::to_json(std::move(response), json_str);
+      metrics.ObserveStage(series, MetricStage::kSerialize,
+                           serialize_timer.Lap());
+      metrics.CountRequest(series, false);
+      ctx->setHeader("Server-Timing", FormatServerTiming(server_timing));
       ctx->send(json_str, APPLICATION_JSON);
       //TODO: move to logger thread
       Logger::Instance()->get().Debug(LOG_DOMAIN_NAME,
                                       std::format("{}", json_str));
       return 200;
     } catch (std::exception& e) {
+      metrics.CountRequest(series, true);
+      ctx->sendString(std::format("unable to serialize:{}", e.what()));
+      return 400;
+    }
+  }
+
+  int HandleInferOCRDetect(const HttpContextPtr& ctx) noexcept {
+    const auto& str = ctx->body();
+    InferOCRRequest parsed_request;
+    std::error_code error_code;
+    MetricsInFlight in_flight;
+    auto& metrics = Metrics::Instance();
+    struct_json::from_json(parsed_request, str, error_code);
+    if (error_code) {
+      metrics.CountRequest(metrics.Series("ocr-detect", ""), true);
+      ctx->sendString(error_code.message());
+      return 400;
+    }
+    auto infer_result = GetOCRModel(parsed_request.model);
+    if (!infer_result) {
+      metrics.CountRequest(metrics.Series("ocr-detect", ""), true);
+      ctx->sendString(infer_result.error().message.c_str());
+      return 400;
+    }
+    const auto series = metrics.Series("ocr-detect", parsed_request.model);
+    auto& infer = infer_result->get();
+    RequestTiming<OCRRunTiming> server_timing;
+    InferOCRDetectResponse response;
+    response.results.reserve(parsed_request.images.size());
+    for (const auto& image_b64 : parsed_request.images) {
+      MetricsTimer timer;
+      auto image = DecodeBase64Image(image_b64);
+      const auto decode_ns = timer.Lap();
+      metrics.ObserveStage(series, MetricStage::kDecode, decode_ns);
+      server_timing.decode_ns += decode_ns;
+      if (!image) {
+        metrics.CountRequest(series, true);
+        ctx->sendString(image.error().message.c_str());
+        return 400;
+      }
+      OCRRunTiming timing;
+      auto result = infer.Detect(*image, &timing);
+      metrics.ObserveRun(series, timing);
+      AddRunTiming(server_timing.run, timing);
+      ++server_timing.computed;
+      if (!result) continue;
+      auto& boxes = response.results.emplace_back();
+      boxes.reserve(result->size());
+      for (const auto& box : *result)
+        boxes.push_back({box.x, box.y, box.width, box.height});
+    }
+    MetricsTimer serialize_timer;
+    try {
+      std::string json_str;
+      struct_json::to_json(std::move(response), json_str);
+      metrics.ObserveStage(series, MetricStage::kSerialize,
+                           serialize_timer.Lap());
+      metrics.CountRequest(series, false);
+      ctx->setHeader("Server-Timing", FormatServerTiming(server_timing));
+      ctx->send(json_str, APPLICATION_JSON);
+      return 200;
+    } catch (std::exception& e) {
+      metrics.CountRequest(series, true);
       ctx->sendString(std::format("unable to serialize:{}", e.what()));
       return 400;
     }
   }
+
+  int HandleInferOCRRecognize(const HttpContextPtr& ctx) noexcept {
+    const auto& str = ctx->body();
+    InferOCRRecognizeRequest parsed_request;
+    std::error_code error_code;
+    MetricsInFlight in_flight;
+    auto& metrics = Metrics::Instance();
+    struct_json::from_json(parsed_request, str, error_code);
+    if (error_code) {
+      metrics.CountRequest(metrics.Series("ocr-recognize", ""), true);
+      ctx->sendString(error_code.message());
+      return 400;
+    }
+    auto infer_result = GetOCRModel(parsed_request.model);
+    if (!infer_result) {
+      metrics.CountRequest(metrics.Series("ocr-recognize", ""), true);
+      ctx->sendString(infer_result.error().message.c_str());
+      return 400;
+    }
+    const auto series = metrics.Series("ocr-recognize", parsed_request.model);
+    auto& infer = infer_result->get();
+    RequestTiming<OCRRunTiming> server_timing;
+    std::vector<OCRFrameResult> all_results;
+    all_results.reserve(parsed_request.images.size());
+    std::vector<cv::Rect> boxes;
+    for (const auto& item : parsed_request.images) {
+      MetricsTimer timer;
+      auto image = DecodeBase64Image(item.image);
+      const auto decode_ns = timer.Lap();
+      metrics.ObserveStage(series, MetricStage::kDecode, decode_ns);
+      server_timing.decode_ns += decode_ns;
+      if (!image) {
+        metrics.CountRequest(series, true);
+        ctx->sendString(image.error().message.c_str());
+        return 400;
+      }
+      boxes.clear();
+      for (const auto& box : item.boxes)
+        boxes.emplace_back(box[0], box[1], box[2], box[3]);
+      OCRRunTiming timing;
+      auto result = infer.Recognize(*image, boxes, INFER_CONFIDENCE_THRESHOLD,
+                                    &timing);
+      metrics.ObserveRun(series, timing);
+      AddRunTiming(server_timing.run, timing);
+      ++server_timing.computed;
+      if (result) all_results.emplace_back(*std::move(result));
+    }
+    return SendOCRResponse(ctx, series, all_results, server_timing);
+  }
+
+  void HandleStreamOpen(const WebSocketChannelPtr& channel,
+                        const HttpRequestPtr& req) noexcept {
+    if (req->Path() != STREAM_PATH) {
+      channel->send(std::format("unknown stream path:{}", req->Path()));
+      channel->close();
+      return;
+    }
+    channel->newContextPtr<StreamSession>();
+  }
+
+  void HandleStreamMessage(const WebSocketChannelPtr& channel,
+                           const std::string& msg) noexcept {
+    auto session = channel->getContextPtr<StreamSession>();
+    if (!session) return;
+    if (channel->opcode == WS_OPCODE_TEXT) {
+      HandleStreamBind(channel, *session, msg);
+      return;
+    }
+    if (!session->yolo && !session->ocr) {
+      channel->send(std::string{"stream is not bound to a model"});
+      return;
+    }
+    {
+      std::lock_guard lock{session->mutex};
+      ++session->received;
+      // keep only the newest frame while the worker is busy
+      if (session->has_pending) ++session->dropped;
+      session->pending_frame.assign(msg);
+      session->has_pending = true;
+      if (session->running) return;
+      session->running = true;
+    }
+    // the cached model is shared with HTTP requests and other streams, its
+    // Run calls are serialized inside the model
+    hv::async([channel, session] { RunStream(channel, *session); });
+  }
+
+  void HandleStreamBind(const WebSocketChannelPtr& channel,
+                        StreamSession& session,
+                        const std::string& msg) noexcept {
+    StreamBindRequest request{.task = "yolo",
+                              .model = {},
+                              .confidence = 0.125f,
+                              .delta = false};
+    std::error_code error_code;
+    struct_json::from_json(request, msg, error_code);
+    if (error_code) {
+      channel->send(error_code.message());
+      return;
+    }
+    std::lock_guard lock{session.mutex};
+    if (session.running) {
+      channel->send(std::string{"unable to rebind a running stream"});
+      return;
+    }
+    StreamBindResponse response{.task = request.task,
+                                .model = request.model,
+                                .delta = request.delta,
+                                .class_names = {}};
+    if (request.task == "yolo") {
+      auto infer_result = GetYOLOModel(request.model);
+      if (!infer_result) {
+        channel->send(infer_result.error().message.c_str());
+        return;
+      }
+      auto& infer = infer_result->get();
+      session.task = StreamTask::kYOLO;
+      session.yolo = &infer;
+      session.ocr = nullptr;
+      response.class_names = std::vector<std::string_view>(
+          infer.class_names().cbegin(), infer.class_names().cend());
+    } else if (request.task == "ocr") {
+      auto infer_result = GetOCRModel(request.model);
+      if (!infer_result) {
+        channel->send(infer_result.error().message.c_str());
+        return;
+      }
+      session.task = StreamTask::kOCR;
+      session.yolo = nullptr;
+      session.ocr = &infer_result->get();
+    } else {
+      channel->send(std::format("unknown stream task:{}", request.task));
+      return;
+    }
+    session.confidence = request.confidence;
+    session.delta = request.delta;
+    session.series = Metrics::Instance().Series("stream", request.model);
+    session.yolo_view.clear();
+    session.ocr_view.clear();
+    std::string json_str;
+    struct_json::to_json(response, json_str);
+    channel->send(json_str);
+  }
+
+  static void RunStream(const WebSocketChannelPtr& channel,
+                        StreamSession& session) noexcept {
+    while (channel->isConnected()) {
+      uint64_t frame_id, dropped;
+      {
+        std::lock_guard lock{session.mutex};
+        if (!session.has_pending) {
+          session.running = false;
+          return;
+        }
+        session.frame.swap(session.pending_frame);
+        session.has_pending = false;
+        frame_id = session.received;
+        dropped = session.dropped;
+      }
+      auto& metrics = Metrics::Instance();
+      MetricsInFlight in_flight;
+      MetricsTimer timer;
+      try {
+        const cv::Mat raw(1, static_cast<int>(session.frame.size()), CV_8UC1,
+                          session.frame.data());
+        cv::imdecode(raw, cv::IMREAD_COLOR, &session.image);
+      } catch (std::exception& e) {
+        metrics.CountRequest(session.series, true);
+        channel->send(std::format("unable to decode frame {}:{}", frame_id,
+                                  e.what()));
+        continue;
+      }
+      if (session.image.empty()) {
+        metrics.CountRequest(session.series, true);
+        channel->send(std::format("unable to decode frame {}", frame_id));
+        continue;
+      }
+      metrics.ObserveStage(session.series, MetricStage::kDecode, timer.Lap());
+      session.message.clear();
+      if (session.task == StreamTask::kYOLO) {
+        YOLORunTiming timing;
+        auto result =
+            session.yolo->Run(session.image, session.confidence, &timing);
+        timer.Lap();
+        metrics.ObserveRun(session.series, timing);
+        if (!result) {
+          metrics.CountRequest(session.series, true);
+          channel->send(result.error().message.c_str());
+          continue;
+        }
+        StreamYOLOMessage message{.frame = frame_id,
+                                  .dropped = dropped,
+                                  .delta = session.delta,
+                                  .results = {},
+                                  .removed = {}};
+        std::vector<YOLOResult> added, removed;
+        auto& current = result->results;
+        if (session.delta)
+          DiffResults(session.yolo_view, current, added, removed);
+        for (const auto& item : session.delta ? added : current)
+          message.results.emplace_back(ToDetectedObject(item));
+        for (const auto& item : removed)
+          message.removed.emplace_back(ToDetectedObject(item));
+        struct_json::to_json(message, session.message);
+      } else {
+        OCRRunTiming timing;
+        auto result =
+            session.ocr->Run(session.image, session.confidence, &timing);
+        timer.Lap();
+        metrics.ObserveRun(session.series, timing);
+        if (!result) {
+          metrics.CountRequest(session.series, true);
+          channel->send(result.error().message.c_str());
+          continue;
+        }
+        StreamOCRMessage message{.frame = frame_id,
+                                 .dropped = dropped,
+                                 .delta = session.delta,
+                                 .results = {},
+                                 .removed = {}};
+        std::vector<OCRResult> added, removed;
+        auto& current = result->results;
+        if (session.delta)
+          DiffResults(session.ocr_view, current, added, removed);
+        for (const auto& item : session.delta ? added : current)
+          message.results.emplace_back(ToOCRLine(item));
+        for (const auto& item : removed)
+          message.removed.emplace_back(ToOCRLine(item));
+        struct_json::to_json(message, session.message);
+      }
+      metrics.ObserveStage(session.series, MetricStage::kSerialize,
+                           timer.Lap());
+      metrics.CountRequest(session.series, false);
+      channel->send(session.message);
+    }
+    std::lock_guard lock{session.mutex};
+    session.running = false;
+  }
 };
 } // namespace vision_simple
 
@@ -451,7 +1552,45 @@ vision_simple::HTTPServer::Create(HTTPServerOptions&& options) {
         VisionSimpleErrorCode::kParameterError,
         std::format("unsupported infer_framework:{} or infer_ep:{}",
                     infer_fw_str, infer_ep_str)});
-  auto infer_context = InferContext::Create(*infer_fw, *infer_ep);
+  InferArgs infer_args;
+  for (auto [arg_key, opt_key, opt_defval] :
+       {std::tuple{INFER_ARG_KEY_SESSION_PRESET,
+                   HTTPSERVER_OPT_KEY_INFER_SESSION_PRESET,
+                   HTTPSERVER_OPT_DEFVAL_INFER_SESSION_PRESET},
+        std::tuple{INFER_ARG_KEY_GLOBAL_THREAD_POOLS,
+                   HTTPSERVER_OPT_KEY_INFER_GLOBAL_THREAD_POOLS,
+                   HTTPSERVER_OPT_DEFVAL_INFER_GLOBAL_THREAD_POOLS},
+        std::tuple{INFER_ARG_KEY_GLOBAL_INTRA_OP_THREADS,
+                   HTTPSERVER_OPT_KEY_INFER_INTRA_OP_THREADS,
+                   HTTPSERVER_OPT_DEFVAL_INFER_INTRA_OP_THREADS},
+        std::tuple{INFER_ARG_KEY_GLOBAL_INTER_OP_THREADS,
+                   HTTPSERVER_OPT_KEY_INFER_INTER_OP_THREADS,
+                   HTTPSERVER_OPT_DEFVAL_INFER_INTER_OP_THREADS},
+        std::tuple{INFER_ARG_KEY_GLOBAL_INTRA_OP_AFFINITY,
+                   HTTPSERVER_OPT_KEY_INFER_INTRA_OP_AFFINITY,
+                   HTTPSERVER_OPT_DEFVAL_INFER_INTRA_OP_AFFINITY},
+        std::tuple{INFER_ARG_KEY_MODEL_CACHE_DIR,
+                   HTTPSERVER_OPT_KEY_INFER_MODEL_CACHE_DIR,
+                   HTTPSERVER_OPT_DEFVAL_INFER_MODEL_CACHE_DIR},
+        std::tuple{INFER_ARG_KEY_AUTOTUNE, HTTPSERVER_OPT_KEY_INFER_AUTOTUNE,
+                   HTTPSERVER_OPT_DEFVAL_INFER_AUTOTUNE},
+        std::tuple{INFER_ARG_KEY_AUTOTUNE_FILE,
+                   HTTPSERVER_OPT_KEY_INFER_AUTOTUNE_FILE,
+                   HTTPSERVER_OPT_DEFVAL_INFER_AUTOTUNE_FILE},
+        std::tuple{INFER_ARG_KEY_HUGE_PAGE_ALLOCATOR,
+                   HTTPSERVER_OPT_KEY_INFER_HUGE_PAGE_ALLOCATOR,
+                   HTTPSERVER_OPT_DEFVAL_INFER_HUGE_PAGE_ALLOCATOR},
+        std::tuple{INFER_ARG_KEY_HUGE_PAGE_MODE,
+                   HTTPSERVER_OPT_KEY_INFER_HUGE_PAGE_MODE,
+                   HTTPSERVER_OPT_DEFVAL_INFER_HUGE_PAGE_MODE},
+        std::tuple{INFER_ARG_KEY_HUGE_PAGE_MAX_CACHED_MB,
+                   HTTPSERVER_OPT_KEY_INFER_HUGE_PAGE_MAX_CACHED_MB,
+                   HTTPSERVER_OPT_DEFVAL_INFER_HUGE_PAGE_MAX_CACHED_MB}}) {
+    const auto& value = options.OptionOrPut(opt_key, opt_defval);
+    if (!value.empty()) infer_args.emplace(arg_key, value);
+  }
+  auto infer_context =
+      InferContext::Create(*infer_fw, *infer_ep, std::move(infer_args));
   if (!infer_context)
     return std::unexpected(VisionSimpleError{
         VisionSimpleErrorCode::kModelError,
@@ -461,6 +1600,17 @@ vision_simple::HTTPServer::Create(HTTPServerOptions&& options) {
   Logger::Instance()->get().Info(LOG_DOMAIN_NAME, std::format(
                                      "Execution Provider:{}",
                                      infer_ep_str));
-  return std::make_unique<HTTPServerImpl>(std::move(options),
-                                          std::move(*infer_context));
+  if (options.OptionOrPut(HTTPSERVER_OPT_KEY_INFER_GLOBAL_THREAD_POOLS,
+                          HTTPSERVER_OPT_DEFVAL_INFER_GLOBAL_THREAD_POOLS) ==
+      "1")
+    WarnIgnoredSessionThreads();
+  auto server = std::make_unique<HTTPServerImpl>(std::move(options),
+                                                 std::move(*infer_context));
+  if (auto result = server->SetupResultCache(); !result)
+    return std::unexpected(std::move(result.error()));
+  if (auto result = server->SetupLocalTransport(); !result)
+    return std::unexpected(std::move(result.error()));
+  server->RegisterGauges();
+  server->PreloadAutoTunedModels();
+  return server;
 }
@@ -16,11 +16,65 @@ namespace vision_simple
     constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_FRAMEWORK{"infer_framework"};
     constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_EP{"infer_ep"};
     constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_DEVICE{"infer_device"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_SESSION_PRESET{"infer_session_preset"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_GLOBAL_THREAD_POOLS{"infer_global_thread_pools"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_INTRA_OP_THREADS{"infer_intra_op_threads"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_INTER_OP_THREADS{"infer_inter_op_threads"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_INTRA_OP_AFFINITY{"infer_intra_op_affinity"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_MODEL_CACHE_DIR{"infer_model_cache_dir"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_AUTOTUNE{"infer_autotune"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_AUTOTUNE_FILE{"infer_autotune_file"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_HUGE_PAGE_ALLOCATOR{"infer_huge_page_allocator"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_HUGE_PAGE_MODE{"infer_huge_page_mode"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_INFER_HUGE_PAGE_MAX_CACHED_MB{"infer_huge_page_max_cached_mb"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_PROFILE_DIR{"profile_dir"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_RESULT_CACHE_ENTRIES{"result_cache_entries"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_RESULT_CACHE_BYTES{"result_cache_bytes"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_LOCAL_IPC_PATH{"local_ipc_path"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_LOCAL_IPC_SHM_NAME{"local_ipc_shm_name"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_LOCAL_IPC_SLOTS{"local_ipc_slots"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_LOCAL_IPC_CLIENT_SLOTS{"local_ipc_client_slots"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_LOCAL_IPC_FRAME_BYTES{"local_ipc_frame_bytes"};
+    constexpr std::string_view HTTPSERVER_OPT_KEY_LOCAL_IPC_RESULT_BYTES{"local_ipc_result_bytes"};
 
     constexpr std::string_view HTTPSERVER_OPT_DEFVAL_STATIC_DIR{"assets/static"};
     constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_FRAMEWORK{"kONNXRUNTIME"};
     constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_EP{"kCPU"};
     constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_DEVICE{"0"};
+    // models.yaml中模型的session配置优先
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_SESSION_PRESET{"kDefault"};
+    // "1": all sessions share one intra-op/inter-op pool, 0 threads means ORT's default;
+    // per-model intra_op_threads/inter_op_threads/allow_spinning are then ignored
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_GLOBAL_THREAD_POOLS{"0"};
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_INTRA_OP_THREADS{"0"};
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_INTER_OP_THREADS{"0"};
+    // empty leaves thread placement to the OS
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_INTRA_OP_AFFINITY{""};
+    // optimized .ort models are cached here, empty disables the cache
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_MODEL_CACHE_DIR{""};
+    // kOff/kLatency/kThroughput, the session settings in models.yaml take precedence;
+    // models with autotune on are loaded and tuned at startup
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_AUTOTUNE{"kOff"};
+    // tuned settings keyed by model hash and CPU model, reused on later starts
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_AUTOTUNE_FILE{"autotune.txt"};
+    // ORT tensors come from the 2MB huge page pool instead of ORT's CPU arena
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_HUGE_PAGE_ALLOCATOR{"0"};
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_HUGE_PAGE_MODE{"kTransparent"};
+    // idle huge page blocks above this are returned to the OS
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_INFER_HUGE_PAGE_MAX_CACHED_MB{"256"};
+    // ORT profiles from /v0/admin/profile are written here, empty disables the endpoint
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_PROFILE_DIR{""};
+    // 0 disables the result cache
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_RESULT_CACHE_ENTRIES{"0"};
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_RESULT_CACHE_BYTES{"67108864"};
+    // empty path disables the local transport
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_LOCAL_IPC_PATH{""};
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_LOCAL_IPC_SHM_NAME{"/vision_simple"};
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_LOCAL_IPC_SLOTS{"16"};
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_LOCAL_IPC_CLIENT_SLOTS{"4"};
+    // 3840x2160 BGR24
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_LOCAL_IPC_FRAME_BYTES{"24883200"};
+    constexpr std::string_view HTTPSERVER_OPT_DEFVAL_LOCAL_IPC_RESULT_BYTES{"65536"};
 
     struct HTTPServerOptions
     {
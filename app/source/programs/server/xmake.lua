@@ -1,8 +1,8 @@
 local target_name = "server"
 local kind = "binary"
 local group_name = "program"
-local pkgs = { "libhv", "turbobase64", "log4cplus" }
-local deps = { "runtime", "infer" }
+local pkgs = { "libhv", "turbobase64" }
+local deps = { "runtime", "infer", "server_core" }
 local syslinks = {}
 local function callback()
     set_basename("vision_simple-server")
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "Infer.h"
+#include "VisionSimpleCommon.h"
+
+namespace vision_simple {
+/*
+ * 本机零拷贝传输协议
+ * 共享内存布局: [LocalRingHeader][frame slot 0..N)[result slot 0..N)
+ * 控制通道: Unix domain socket(SOCK_SEQPACKET)，每条消息一个结构体
+ *   1. 连接后服务端发送LocalHello，告知客户端可用的slot区间
+ *   2. 客户端把原始帧写入自己的frame slot，发送LocalRequest
+ *   3. 服务端直接在映射的slot上推理，结果写入同下标的result slot，回复LocalResponse
+ */
+constexpr uint32_t LOCAL_TRANSPORT_MAGIC = 0x56534C54;  // "VSLT"
+constexpr uint32_t LOCAL_TRANSPORT_VERSION = 1;
+constexpr size_t LOCAL_TRANSPORT_MODEL_NAME_SIZE = 64;
+
+enum class LocalTask : uint32_t { kYOLO = 0, kOCR };
+
+enum class LocalPixelFormat : uint32_t { kBGR24 = 0, kBGRA32, kGRAY8 };
+
+enum class LocalResultKind : uint32_t { kYOLO = 0, kOCR, kError };
+
+struct LocalRingHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slot_count;
+  uint32_t reserved;
+  uint64_t frame_slot_bytes;
+  uint64_t result_slot_bytes;
+  uint64_t frame_ring_offset;
+  uint64_t result_ring_offset;
+};
+
+struct LocalHello {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t first_slot;
+  uint32_t slot_count;
+  uint64_t frame_slot_bytes;
+  uint64_t result_slot_bytes;
+};
+
+struct LocalRequest {
+  uint32_t magic;
+  uint32_t slot;
+  LocalTask task;
+  LocalPixelFormat pixel_format;
+  uint32_t width, height, stride;
+  float confidence;
+  uint64_t sequence;
+  char model[LOCAL_TRANSPORT_MODEL_NAME_SIZE];
+};
+
+struct LocalResponse {
+  uint32_t slot;
+  VisionSimpleErrorCode code;
+  uint64_t sequence;
+  uint32_t count;
+  uint32_t bytes;
+};
+
+// result slot: [LocalResultHeader][records...][text blob(OCR)]
+struct LocalResultHeader {
+  LocalResultKind kind;
+  uint32_t count;
+  uint32_t truncated;
+  uint32_t text_bytes;
+};
+
+struct LocalYOLORecord {
+  int32_t class_id;
+  float confidence;
+  int32_t bbox[4];
+};
+
+struct LocalOCRRecord {
+  float confidence;
+  int32_t bbox[4];
+  uint32_t text_offset;
+  uint32_t text_size;
+};
+
+struct LocalTransportOptions {
+  std::string socket_path;
+  std::string shm_name;
+  uint32_t slot_count;
+  uint32_t client_slots;
+  uint64_t frame_slot_bytes;
+  uint64_t result_slot_bytes;
+};
+
+class LocalTransport {
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+
+  explicit LocalTransport(std::unique_ptr<Impl> impl);
+
+ public:
+  using YOLOModelGetter = std::function<VSResult<std::reference_wrapper<InferYOLO>>(
+      const std::string& name)>;
+  using OCRModelGetter = std::function<VSResult<std::reference_wrapper<InferOCR>>(
+      const std::string& name)>;
+
+  static VSResult<std::unique_ptr<LocalTransport>> Create(
+      LocalTransportOptions options, YOLOModelGetter yolo_getter,
+      OCRModelGetter ocr_getter) noexcept;
+  LocalTransport(const LocalTransport&) = delete;
+  LocalTransport& operator=(const LocalTransport&) = delete;
+  ~LocalTransport();
+
+  const LocalTransportOptions& options() const noexcept;
+  void StartAsync() noexcept;
+  void Stop() noexcept;
+};
+}  // namespace vision_simple
@@ -0,0 +1,102 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace vision_simple {
+struct YOLORunTiming;
+struct OCRRunTiming;
+
+enum class MetricStage : uint8_t {
+  kDecode = 0,
+  kPreprocess,
+  kInference,
+  kPostprocess,
+  kSerialize,
+  kCount
+};
+
+using MetricSeries = uint32_t;
+
+/**
+ * Prometheus指标
+ * 热路径只写当前线程独占的分片(relaxed原子操作，无锁无竞争)，
+ * 抓取时汇总所有线程的分片
+ */
+class Metrics {
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+
+  Metrics();
+
+ public:
+  using GaugeFunc = std::function<double()>;
+  // 每个分片最多容纳的(endpoint,model)组合，超出的计入overflow序列
+  static constexpr MetricSeries MAX_SERIES = 256;
+
+  static Metrics& Instance() noexcept;
+  ~Metrics();
+  Metrics(const Metrics&) = delete;
+  Metrics& operator=(const Metrics&) = delete;
+
+  /**
+   * 获取(endpoint,model)对应的序列号，线程内缓存，首次注册时才加锁
+   */
+  MetricSeries Series(std::string_view endpoint,
+                      std::string_view model) noexcept;
+  void ObserveStage(MetricSeries series, MetricStage stage,
+                    uint64_t nanoseconds) noexcept;
+  // 将Run的分阶段耗时归入preprocess/inference/postprocess
+  void ObserveRun(MetricSeries series, const YOLORunTiming& timing) noexcept;
+  void ObserveRun(MetricSeries series, const OCRRunTiming& timing) noexcept;
+  void CountRequest(MetricSeries series, bool error) noexcept;
+  void AddInFlight(int64_t delta) noexcept;
+  /**
+   * 注册抓取时计算的gauge
+   * @param name 指标名
+   * @param help 描述
+   * @param labels 形如 task="yolo" 的标签，可为空
+   * @param owner func引用的对象，析构前需以其调用RemoveGauges
+   */
+  void AddGauge(std::string name, std::string help, std::string labels,
+                GaugeFunc func, const void* owner = nullptr);
+  /**
+   * 注册抓取时读取的counter，func需单调不减，参数同AddGauge，name以_total结尾
+   */
+  void AddCounter(std::string name, std::string help, std::string labels,
+                  GaugeFunc func, const void* owner = nullptr);
+  /**
+   * 移除owner注册的gauge和counter，并等待正在求值的抓取结束，
+   * 返回后不会再调用其func
+   */
+  void RemoveGauges(const void* owner);
+  std::string Render() const;
+};
+
+class MetricsTimer {
+  std::chrono::steady_clock::time_point start_{
+      std::chrono::steady_clock::now()};
+
+ public:
+  // 返回距上次Lap(或构造)的纳秒数并重新计时
+  uint64_t Lap() noexcept {
+    const auto now = std::chrono::steady_clock::now();
+    const auto elapsed =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_);
+    start_ = now;
+    return static_cast<uint64_t>(elapsed.count());
+  }
+};
+
+// 请求期间计入in-flight
+class MetricsInFlight {
+ public:
+  MetricsInFlight() noexcept { Metrics::Instance().AddInFlight(1); }
+  ~MetricsInFlight() { Metrics::Instance().AddInFlight(-1); }
+  MetricsInFlight(const MetricsInFlight&) = delete;
+  MetricsInFlight& operator=(const MetricsInFlight&) = delete;
+};
+}  // namespace vision_simple
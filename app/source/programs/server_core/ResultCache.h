@@ -0,0 +1,162 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "Hash.h"
+#include "LRUCache.h"
+#include "VisionSimpleCommon.h"
+
+namespace vision_simple {
+// 第二个摘要的种子，与第一个摘要组成128位，不同图片的键实际不会碰撞
+constexpr uint64_t RESULT_CACHE_KEY_SEED{0x2545F4914F6CDD1Dull};
+
+struct ResultCacheKey {
+  uint64_t hash;
+  uint64_t hash2;
+  uint64_t size;
+
+  bool operator==(const ResultCacheKey& other) const noexcept = default;
+};
+
+struct ResultCacheKeyHash {
+  size_t operator()(const ResultCacheKey& key) const noexcept {
+    return static_cast<size_t>(key.hash);
+  }
+};
+
+struct ResultCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t coalesced;
+  uint64_t evictions;
+  uint64_t entries;
+  uint64_t bytes;
+  uint64_t max_entries;
+  uint64_t max_bytes;
+};
+
+/**
+ * 由编码后的图片数据、模型和推理参数生成缓存键
+ * @param task 任务类型，如yolo/ocr
+ * @param model 模型名
+ * @param confidence 置信度阈值
+ * @param data 编码后的图片数据(可以是base64文本)
+ */
+inline ResultCacheKey MakeResultCacheKey(std::string_view task,
+                                         std::string_view model,
+                                         float confidence,
+                                         std::string_view data) noexcept {
+  uint32_t confidence_bits;
+  std::memcpy(&confidence_bits, &confidence, sizeof(confidence_bits));
+  auto params = HashCombine(Hash64(task), Hash64(model));
+  params = HashCombine(params, confidence_bits);
+  return ResultCacheKey{
+      HashCombine(Hash64(data), params),
+      HashCombine(Hash64(data, RESULT_CACHE_KEY_SEED), params), data.size()};
+}
+
+/**
+ * 线程安全的推理结果缓存
+ * 相同键的并发请求只计算一次，其余请求等待该次计算的结果
+ * @tparam V 缓存的结果类型
+ */
+template <typename V>
+class ResultCache {
+  struct InFlight {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done{false};
+    std::optional<V> value;
+    VisionSimpleErrorCode code{VisionSimpleErrorCode::kOK};
+    std::string message;
+  };
+
+  using SizeOf = std::function<size_t(const V&)>;
+
+  mutable std::mutex mutex_;
+  LRUCache<ResultCacheKey, V, ResultCacheKeyHash> cache_;
+  std::unordered_map<ResultCacheKey, std::shared_ptr<InFlight>,
+                     ResultCacheKeyHash>
+      in_flight_;
+  SizeOf size_of_;
+  std::atomic<uint64_t> hits_{0}, misses_{0}, coalesced_{0};
+
+ public:
+  ResultCache(size_t max_entries, size_t max_bytes, SizeOf size_of)
+      : cache_(max_entries, max_bytes), size_of_(std::move(size_of)) {}
+
+  template <typename F>
+  VSResult<V> GetOrCompute(const ResultCacheKey& key, F&& compute) noexcept {
+    std::shared_ptr<InFlight> flight;
+    bool owner = false;
+    {
+      std::lock_guard lock{mutex_};
+      if (auto* value = cache_.Get(key)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return *value;
+      }
+      auto [it, inserted] = in_flight_.try_emplace(key);
+      if (inserted) {
+        it->second = std::make_shared<InFlight>();
+        owner = true;
+        misses_.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        coalesced_.fetch_add(1, std::memory_order_relaxed);
+      }
+      flight = it->second;
+    }
+    if (!owner) {
+      std::unique_lock lock{flight->mutex};
+      flight->cv.wait(lock, [&flight] { return flight->done; });
+      if (flight->value) return *flight->value;
+      return MK_VSERROR(flight->code, flight->message);
+    }
+    VSResult<V> result = MK_VSERROR(VisionSimpleErrorCode::kUnknownError,
+                                    "result cache compute failed");
+    try {
+      result = compute();
+    } catch (std::exception& e) {
+      result = MK_VSERROR(VisionSimpleErrorCode::kRuntimeError, e.what());
+    }
+    {
+      std::lock_guard lock{mutex_};
+      if (result) cache_.Put(key, *result, size_of_(*result));
+      in_flight_.erase(key);
+    }
+    {
+      std::lock_guard lock{flight->mutex};
+      if (result) {
+        flight->value = *result;
+      } else {
+        flight->code = result.error().code;
+        flight->message.assign(result.error().message.begin(),
+                               result.error().message.end());
+      }
+      flight->done = true;
+    }
+    flight->cv.notify_all();
+    return result;
+  }
+
+  ResultCacheStats stats() const noexcept {
+    std::lock_guard lock{mutex_};
+    return ResultCacheStats{
+        .hits = hits_.load(std::memory_order_relaxed),
+        .misses = misses_.load(std::memory_order_relaxed),
+        .coalesced = coalesced_.load(std::memory_order_relaxed),
+        .evictions = cache_.evictions(),
+        .entries = cache_.size(),
+        .bytes = cache_.bytes(),
+        .max_entries = cache_.max_entries(),
+        .max_bytes = cache_.max_bytes(),
+    };
+  }
+};
+}  // namespace vision_simple
@@ -0,0 +1,480 @@
+#include "LocalTransport.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <list>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "Logger.h"
+#include "Metrics.h"
+#define LOG_DOMAIN_NAME "LocalTransport"
+
+using namespace vision_simple;
+
+#if defined(__linux__)
+namespace {
+struct Connection {
+  // 在mutex内关闭并置为-1，Stop不会shutdown已关闭或被复用的fd
+  int fd{-1};
+  uint32_t group{0};
+  std::atomic<bool> done{false};
+  std::jthread thread;
+};
+
+// 每个连接独占的推理状态，避免每帧查找模型
+// 模型与HTTP请求及其他连接共享，Run在模型内部串行执行
+struct ConnectionState {
+  std::string model_name;
+  LocalTask task{LocalTask::kYOLO};
+  InferYOLO* yolo{nullptr};
+  InferOCR* ocr{nullptr};
+  MetricSeries series{0};
+  cv::Mat converted;
+};
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment = 4096) noexcept {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+uint32_t WriteError(std::span<uint8_t> slot, const VisionSimpleError& error) {
+  auto& header = *reinterpret_cast<LocalResultHeader*>(slot.data());
+  const auto text_bytes = std::min<size_t>(
+      error.message.size(), slot.size() - sizeof(LocalResultHeader));
+  std::memcpy(slot.data() + sizeof(LocalResultHeader), error.message.data(),
+              text_bytes);
+  header = LocalResultHeader{.kind = LocalResultKind::kError,
+                             .count = 0,
+                             .truncated = text_bytes < error.message.size(),
+                             .text_bytes = static_cast<uint32_t>(text_bytes)};
+  return static_cast<uint32_t>(sizeof(LocalResultHeader) + text_bytes);
+}
+
+uint32_t WriteResults(std::span<uint8_t> slot, const YOLOFrameResult& frame) {
+  auto& header = *reinterpret_cast<LocalResultHeader*>(slot.data());
+  auto* records =
+      reinterpret_cast<LocalYOLORecord*>(slot.data() + sizeof(header));
+  const auto capacity =
+      (slot.size() - sizeof(header)) / sizeof(LocalYOLORecord);
+  const auto count = std::min(capacity, frame.results.size());
+  for (size_t i = 0; i < count; ++i) {
+    const auto& result = frame.results[i];
+    const auto& bbox = result.bbox;
+    records[i] = LocalYOLORecord{
+        .class_id = result.class_id,
+        .confidence = result.confidence,
+        .bbox = {bbox.x, bbox.y, bbox.width, bbox.height},
+    };
+  }
+  header = LocalResultHeader{.kind = LocalResultKind::kYOLO,
+                             .count = static_cast<uint32_t>(count),
+                             .truncated = count < frame.results.size(),
+                             .text_bytes = 0};
+  return static_cast<uint32_t>(sizeof(header) +
+                               count * sizeof(LocalYOLORecord));
+}
+
+uint32_t WriteResults(std::span<uint8_t> slot, const OCRFrameResult& frame) {
+  auto& header = *reinterpret_cast<LocalResultHeader*>(slot.data());
+  auto* records =
+      reinterpret_cast<LocalOCRRecord*>(slot.data() + sizeof(header));
+  const auto available = slot.size() - sizeof(header);
+  // 记录区在前，文本区紧随其后，先按记录数确定文本区起点
+  const auto count = std::min(available / sizeof(LocalOCRRecord),
+                              frame.results.size());
+  auto* text_base = reinterpret_cast<uint8_t*>(records + count);
+  size_t text_capacity = available - count * sizeof(LocalOCRRecord);
+  size_t text_bytes = 0;
+  bool truncated = count < frame.results.size();
+  for (size_t i = 0; i < count; ++i) {
+    const auto& result = frame.results[i];
+    const auto& rect = result.rect;
+    const auto size = std::min(result.line.size(), text_capacity - text_bytes);
+    truncated |= size < result.line.size();
+    std::memcpy(text_base + text_bytes, result.line.data(), size);
+    records[i] = LocalOCRRecord{
+        .confidence = result.confidence,
+        .bbox = {rect.x, rect.y, rect.width, rect.height},
+        .text_offset = static_cast<uint32_t>(text_bytes),
+        .text_size = static_cast<uint32_t>(size),
+    };
+    text_bytes += size;
+  }
+  header = LocalResultHeader{.kind = LocalResultKind::kOCR,
+                             .count = static_cast<uint32_t>(count),
+                             .truncated = truncated,
+                             .text_bytes = static_cast<uint32_t>(text_bytes)};
+  return static_cast<uint32_t>(sizeof(header) +
+                               count * sizeof(LocalOCRRecord) + text_bytes);
+}
+}  // namespace
+
+struct vision_simple::LocalTransport::Impl {
+  LocalTransportOptions options;
+  YOLOModelGetter yolo_getter;
+  OCRModelGetter ocr_getter;
+  int shm_fd{-1};
+  uint8_t* base{nullptr};
+  size_t mapped_bytes{0};
+  int listen_fd{-1};
+  std::atomic<bool> running{false};
+  std::mutex mutex;
+  std::vector<bool> leased_groups;
+  std::list<Connection> connections;
+  std::jthread accept_thread;
+
+  ~Impl() {
+    Stop();
+    if (base) munmap(base, mapped_bytes);
+    if (shm_fd >= 0) {
+      close(shm_fd);
+      shm_unlink(options.shm_name.c_str());
+    }
+    if (listen_fd >= 0) {
+      close(listen_fd);
+      unlink(options.socket_path.c_str());
+    }
+  }
+
+  LocalRingHeader& header() const noexcept {
+    return *reinterpret_cast<LocalRingHeader*>(base);
+  }
+
+  std::span<uint8_t> FrameSlot(uint32_t slot) const noexcept {
+    return {base + header().frame_ring_offset + slot * options.frame_slot_bytes,
+            options.frame_slot_bytes};
+  }
+
+  std::span<uint8_t> ResultSlot(uint32_t slot) const noexcept {
+    return {
+        base + header().result_ring_offset + slot * options.result_slot_bytes,
+        options.result_slot_bytes};
+  }
+
+  VSResult<void> Map() noexcept {
+    const uint64_t frame_ring_offset = AlignUp(sizeof(LocalRingHeader));
+    const uint64_t result_ring_offset = AlignUp(
+        frame_ring_offset + options.frame_slot_bytes * options.slot_count);
+    mapped_bytes = AlignUp(result_ring_offset +
+                           options.result_slot_bytes * options.slot_count);
+    shm_unlink(options.shm_name.c_str());
+    shm_fd = shm_open(options.shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR,
+                      0660);
+    if (shm_fd < 0)
+      return MK_VSERROR(VisionSimpleErrorCode::kIOError,
+                        std::format("unable to create shared memory {}:{}",
+                                    options.shm_name, std::strerror(errno)));
+    if (ftruncate(shm_fd, static_cast<off_t>(mapped_bytes)) != 0)
+      return MK_VSERROR(VisionSimpleErrorCode::kIOError,
+                        std::format("unable to resize shared memory {}:{}",
+                                    options.shm_name, std::strerror(errno)));
+    void* addr = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, shm_fd, 0);
+    if (addr == MAP_FAILED)
+      return MK_VSERROR(VisionSimpleErrorCode::kIOError,
+                        std::format("unable to map shared memory {}:{}",
+                                    options.shm_name, std::strerror(errno)));
+    base = static_cast<uint8_t*>(addr);
+    header() = LocalRingHeader{.magic = LOCAL_TRANSPORT_MAGIC,
+                               .version = LOCAL_TRANSPORT_VERSION,
+                               .slot_count = options.slot_count,
+                               .reserved = 0,
+                               .frame_slot_bytes = options.frame_slot_bytes,
+                               .result_slot_bytes = options.result_slot_bytes,
+                               .frame_ring_offset = frame_ring_offset,
+                               .result_ring_offset = result_ring_offset};
+    return {};
+  }
+
+  VSResult<void> Listen() noexcept {
+    sockaddr_un addr{};
+    if (options.socket_path.size() >= sizeof(addr.sun_path))
+      return MK_VSERROR(
+          VisionSimpleErrorCode::kParameterError,
+          std::format("socket path too long:{}", options.socket_path));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, options.socket_path.c_str(),
+                options.socket_path.size() + 1);
+    listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0)
+      return MK_VSERROR(VisionSimpleErrorCode::kIOError,
+                        std::format("unable to create socket:{}",
+                                    std::strerror(errno)));
+    unlink(options.socket_path.c_str());
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) !=
+            0 ||
+        listen(listen_fd, 16) != 0)
+      return MK_VSERROR(VisionSimpleErrorCode::kIOError,
+                        std::format("unable to listen on {}:{}",
+                                    options.socket_path,
+                                    std::strerror(errno)));
+    return {};
+  }
+
+  void StartAsync() {
+    if (running.exchange(true)) return;
+    accept_thread = std::jthread{[this] { AcceptLoop(); }};
+    Logger::Instance()->get().Info(
+        LOG_DOMAIN_NAME,
+        std::format("listening on {} with shared memory {} ({} slots)",
+                    options.socket_path, options.shm_name,
+                    options.slot_count));
+  }
+
+  void Stop() {
+    if (!running.exchange(false)) return;
+    shutdown(listen_fd, SHUT_RDWR);
+    {
+      std::lock_guard lock{mutex};
+      for (auto& connection : connections)
+        if (connection.fd >= 0) shutdown(connection.fd, SHUT_RDWR);
+    }
+    if (accept_thread.joinable()) accept_thread.join();
+    // 连接线程退出时需要获取mutex，因此在锁外join
+    std::list<Connection> stopped;
+    {
+      std::lock_guard lock{mutex};
+      stopped.splice(stopped.end(), connections);
+    }
+    stopped.clear();
+  }
+
+  void ReapConnections() {
+    std::lock_guard lock{mutex};
+    std::erase_if(connections,
+                  [](const Connection& c) { return c.done.load(); });
+  }
+
+  void AcceptLoop() {
+    while (running.load()) {
+      const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+      if (fd < 0) {
+        if (errno == EINTR) continue;
+        break;
+      }
+      ReapConnections();
+      std::lock_guard lock{mutex};
+      auto it = std::ranges::find(leased_groups, false);
+      LocalHello hello{.magic = LOCAL_TRANSPORT_MAGIC,
+                       .version = LOCAL_TRANSPORT_VERSION,
+                       .first_slot = 0,
+                       .slot_count = 0,
+                       .frame_slot_bytes = options.frame_slot_bytes,
+                       .result_slot_bytes = options.result_slot_bytes};
+      if (it == leased_groups.end()) {
+        // 没有空闲slot，告知客户端后关闭
+        send(fd, &hello, sizeof(hello), MSG_NOSIGNAL);
+        close(fd);
+        continue;
+      }
+      *it = true;
+      const auto group =
+          static_cast<uint32_t>(std::distance(leased_groups.begin(), it));
+      hello.first_slot = group * options.client_slots;
+      hello.slot_count = options.client_slots;
+      auto& connection = connections.emplace_back();
+      connection.fd = fd;
+      connection.group = group;
+      if (send(fd, &hello, sizeof(hello), MSG_NOSIGNAL) != sizeof(hello)) {
+        close(fd);
+        connection.fd = -1;
+        leased_groups[group] = false;
+        connection.done.store(true);
+        continue;
+      }
+      connection.thread =
+          std::jthread{[this, &connection] { Serve(connection); }};
+    }
+  }
+
+  void Serve(Connection& connection) {
+    ConnectionState state;
+    const uint32_t first_slot = connection.group * options.client_slots;
+    LocalRequest request{};
+    while (running.load()) {
+      const auto n = recv(connection.fd, &request, sizeof(request), 0);
+      if (n != sizeof(request)) break;
+      LocalResponse response{.slot = request.slot,
+                             .code = VisionSimpleErrorCode::kOK,
+                             .sequence = request.sequence,
+                             .count = 0,
+                             .bytes = 0};
+      if (request.magic != LOCAL_TRANSPORT_MAGIC ||
+          request.slot < first_slot ||
+          request.slot >= first_slot + options.client_slots) {
+        // slot不属于该连接，不能写回结果
+        response.code = VisionSimpleErrorCode::kParameterError;
+      } else {
+        Run(state, request, response);
+      }
+      if (send(connection.fd, &response, sizeof(response), MSG_NOSIGNAL) !=
+          sizeof(response))
+        break;
+    }
+    {
+      std::lock_guard lock{mutex};
+      close(connection.fd);
+      connection.fd = -1;
+      leased_groups[connection.group] = false;
+    }
+    connection.done.store(true);
+  }
+
+  VSResult<cv::Mat> WrapFrame(ConnectionState& state,
+                              const LocalRequest& request) {
+    int type = CV_8UC3, channels = 3;
+    if (request.pixel_format == LocalPixelFormat::kBGRA32) {
+      type = CV_8UC4;
+      channels = 4;
+    } else if (request.pixel_format == LocalPixelFormat::kGRAY8) {
+      type = CV_8UC1;
+      channels = 1;
+    } else if (request.pixel_format != LocalPixelFormat::kBGR24) {
+      return MK_VSERROR(VisionSimpleErrorCode::kParameterError,
+                        "unsupported pixel format");
+    }
+    const uint64_t stride = request.stride
+                                ? request.stride
+                                : uint64_t{request.width} * channels;
+    if (request.width == 0 || request.height == 0 ||
+        stride < uint64_t{request.width} * channels ||
+        stride * request.height > options.frame_slot_bytes)
+      return MK_VSERROR(
+          VisionSimpleErrorCode::kParameterError,
+          std::format("invalid frame {}x{} stride:{}", request.width,
+                      request.height, stride));
+    // 直接引用映射的slot，不拷贝
+    cv::Mat frame(static_cast<int>(request.height),
+                  static_cast<int>(request.width), type,
+                  FrameSlot(request.slot).data(), stride);
+    if (channels == 3) return frame;
+    cv::cvtColor(frame, state.converted,
+                 channels == 4 ? cv::COLOR_BGRA2BGR : cv::COLOR_GRAY2BGR);
+    return state.converted;
+  }
+
+  VSResult<void> BindModel(ConnectionState& state,
+                           const LocalRequest& request) {
+    const std::string name{
+        request.model,
+        strnlen(request.model, LOCAL_TRANSPORT_MODEL_NAME_SIZE)};
+    if (name == state.model_name && request.task == state.task) return {};
+    state.model_name.clear();
+    if (request.task == LocalTask::kYOLO) {
+      auto result = yolo_getter(name);
+      if (!result) return std::unexpected(std::move(result.error()));
+      state.yolo = &result->get();
+    } else if (request.task == LocalTask::kOCR) {
+      auto result = ocr_getter(name);
+      if (!result) return std::unexpected(std::move(result.error()));
+      state.ocr = &result->get();
+    } else {
+      return MK_VSERROR(VisionSimpleErrorCode::kParameterError,
+                        "unsupported task");
+    }
+    state.task = request.task;
+    state.model_name = name;
+    state.series = Metrics::Instance().Series("local", name);
+    return {};
+  }
+
+  void Run(ConnectionState& state, const LocalRequest& request,
+           LocalResponse& response) {
+    auto& metrics = Metrics::Instance();
+    MetricsInFlight in_flight;
+    MetricsTimer timer;
+    auto result_slot = ResultSlot(request.slot);
+    auto fail = [&](const VisionSimpleError& error) {
+      response.code = error.code;
+      response.bytes = WriteError(result_slot, error);
+      metrics.CountRequest(state.series, true);
+    };
+    if (auto bind_result = BindModel(state, request); !bind_result)
+      return fail(bind_result.error());
+    auto frame_result = WrapFrame(state, request);
+    metrics.ObserveStage(state.series, MetricStage::kDecode, timer.Lap());
+    if (!frame_result) return fail(frame_result.error());
+    if (state.task == LocalTask::kYOLO) {
+      YOLORunTiming timing;
+      auto result = state.yolo->Run(*frame_result, request.confidence, &timing);
+      timer.Lap();
+      metrics.ObserveRun(state.series, timing);
+      if (!result) return fail(result.error());
+      response.count = static_cast<uint32_t>(result->results.size());
+      response.bytes = WriteResults(result_slot, *result);
+    } else {
+      OCRRunTiming timing;
+      auto result = state.ocr->Run(*frame_result, request.confidence, &timing);
+      timer.Lap();
+      metrics.ObserveRun(state.series, timing);
+      if (!result) return fail(result.error());
+      response.count = static_cast<uint32_t>(result->results.size());
+      response.bytes = WriteResults(result_slot, *result);
+    }
+    metrics.ObserveStage(state.series, MetricStage::kSerialize, timer.Lap());
+    metrics.CountRequest(state.series, false);
+  }
+};
+
+VSResult<std::unique_ptr<LocalTransport>> LocalTransport::Create(
+    LocalTransportOptions options, YOLOModelGetter yolo_getter,
+    OCRModelGetter ocr_getter) noexcept {
+  if (options.slot_count == 0 || options.client_slots == 0 ||
+      options.client_slots > options.slot_count ||
+      options.frame_slot_bytes == 0 ||
+      options.result_slot_bytes < sizeof(LocalResultHeader))
+    return MK_VSERROR(VisionSimpleErrorCode::kParameterError,
+                      std::format("invalid local transport slots:{}/{}",
+                                  options.client_slots, options.slot_count));
+  auto impl = std::make_unique<Impl>();
+  impl->leased_groups.resize(options.slot_count / options.client_slots, false);
+  impl->options = std::move(options);
+  impl->yolo_getter = std::move(yolo_getter);
+  impl->ocr_getter = std::move(ocr_getter);
+  if (auto result = impl->Map(); !result)
+    return std::unexpected(std::move(result.error()));
+  if (auto result = impl->Listen(); !result)
+    return std::unexpected(std::move(result.error()));
+  return std::unique_ptr<LocalTransport>(new LocalTransport{std::move(impl)});
+}
+
+void LocalTransport::StartAsync() noexcept { impl_->StartAsync(); }
+
+void LocalTransport::Stop() noexcept { impl_->Stop(); }
+#else
+struct vision_simple::LocalTransport::Impl {
+  LocalTransportOptions options;
+};
+
+VSResult<std::unique_ptr<LocalTransport>> LocalTransport::Create(
+    LocalTransportOptions options, YOLOModelGetter yolo_getter,
+    OCRModelGetter ocr_getter) noexcept {
+  return std::unexpected(VisionSimpleError::Unimplemented());
+}
+
+void LocalTransport::StartAsync() noexcept {}
+
+void LocalTransport::Stop() noexcept {}
+#endif
+
+LocalTransport::LocalTransport(std::unique_ptr<Impl> impl)
+    : impl_(std::move(impl)) {}
+
+LocalTransport::~LocalTransport() = default;
+
+const LocalTransportOptions& LocalTransport::options() const noexcept {
+  return impl_->options;
+}
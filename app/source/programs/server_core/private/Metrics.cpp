@@ -0,0 +1,336 @@
+#include "Metrics.h"
+
+#include <array>
+#include <atomic>
+#include <format>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Infer.h"
+
+using namespace vision_simple;
+
+namespace {
+constexpr auto STAGE_COUNT = static_cast<size_t>(MetricStage::kCount);
+constexpr std::array<std::string_view, STAGE_COUNT> STAGE_NAMES = {
+    "decode", "preprocess", "inference", "postprocess", "serialize"};
+// 桶上界(纳秒)，最后一个桶为+Inf
+constexpr std::array<uint64_t, 14> BUCKET_BOUNDS_NS = {
+    500'000,     1'000'000,     2'500'000,     5'000'000,   10'000'000,
+    25'000'000,  50'000'000,    100'000'000,   250'000'000, 500'000'000,
+    1'000'000'000, 2'500'000'000, 5'000'000'000, 10'000'000'000};
+constexpr std::array<std::string_view, 14> BUCKET_LABELS = {
+    "0.0005", "0.001", "0.0025", "0.005", "0.01", "0.025", "0.05",
+    "0.1",    "0.25",  "0.5",    "1",     "2.5",  "5",     "10"};
+constexpr size_t BUCKET_COUNT = BUCKET_BOUNDS_NS.size() + 1;
+constexpr MetricSeries OVERFLOW_SERIES = 0;
+
+// 分片只由所属线程写入，load+store即可，避免lock前缀
+inline void Bump(std::atomic<uint64_t>& value, uint64_t delta) noexcept {
+  value.store(value.load(std::memory_order_relaxed) + delta,
+              std::memory_order_relaxed);
+}
+
+struct StageHistogram {
+  std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+  std::atomic<uint64_t> sum_ns{0};
+  std::atomic<uint64_t> count{0};
+};
+
+struct SeriesCells {
+  std::array<StageHistogram, STAGE_COUNT> stages{};
+  std::atomic<uint64_t> requests{0};
+  std::atomic<uint64_t> errors{0};
+};
+
+struct Shard {
+  std::array<std::atomic<SeriesCells*>, Metrics::MAX_SERIES> series{};
+  std::atomic<int64_t> in_flight{0};
+
+  ~Shard() {
+    for (auto& cells : series) delete cells.load();
+  }
+
+  SeriesCells& Cells(MetricSeries id) {
+    auto* cells = series[id].load(std::memory_order_relaxed);
+    if (!cells) {
+      cells = new SeriesCells{};
+      series[id].store(cells, std::memory_order_release);
+    }
+    return *cells;
+  }
+};
+
+std::string EscapeLabel(std::string_view value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped.push_back('\\');
+      escaped.push_back(c);
+    } else if (c == '\n') {
+      escaped.append("\\n");
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+}  // namespace
+
+struct vision_simple::Metrics::Impl {
+  struct Gauge {
+    std::string name, help, labels;
+    GaugeFunc func;
+    const void* owner;
+    // gauge或counter
+    std::string_view type;
+  };
+
+  mutable std::mutex mutex;
+  mutable std::mutex gauge_mutex;
+  // 抓取在锁外求值gauge期间共享持有，RemoveGauges独占获取以等待求值结束，
+  // 返回后owner即可安全析构
+  mutable std::shared_mutex render_mutex;
+  std::vector<std::shared_ptr<Shard>> shards;
+  std::vector<std::pair<std::string, std::string>> series_labels{
+      {"overflow", "overflow"}};
+  std::unordered_map<std::string, MetricSeries> series_index;
+  std::vector<Gauge> gauges;
+
+  Shard& LocalShard() {
+    thread_local std::shared_ptr<Shard> shard;
+    if (!shard) {
+      shard = std::make_shared<Shard>();
+      std::lock_guard lock{mutex};
+      shards.emplace_back(shard);
+    }
+    return *shard;
+  }
+};
+
+Metrics::Metrics() : impl_(std::make_unique<Impl>()) {}
+
+Metrics::~Metrics() = default;
+
+Metrics& Metrics::Instance() noexcept {
+  static Metrics instance;
+  return instance;
+}
+
+MetricSeries Metrics::Series(std::string_view endpoint,
+                             std::string_view model) noexcept {
+  thread_local std::unordered_map<std::string, MetricSeries> cache;
+  thread_local std::string key;
+  // 内存不足时计入overflow序列
+  try {
+    key.assign(endpoint);
+    key.push_back('\0');
+    key.append(model);
+    if (auto it = cache.find(key); it != cache.end()) return it->second;
+    MetricSeries id = OVERFLOW_SERIES;
+    {
+      std::lock_guard lock{impl_->mutex};
+      if (auto it = impl_->series_index.find(key);
+          it != impl_->series_index.end()) {
+        id = it->second;
+      } else if (impl_->series_labels.size() < MAX_SERIES) {
+        id = static_cast<MetricSeries>(impl_->series_labels.size());
+        impl_->series_labels.emplace_back(endpoint, model);
+        impl_->series_index.emplace(key, id);
+      }
+    }
+    cache.emplace(key, id);
+    return id;
+  } catch (std::bad_alloc&) {
+    return OVERFLOW_SERIES;
+  }
+}
+
+void Metrics::ObserveStage(MetricSeries series, MetricStage stage,
+                           uint64_t nanoseconds) noexcept {
+  auto& histogram =
+      impl_->LocalShard().Cells(series).stages[static_cast<size_t>(stage)];
+  size_t bucket = 0;
+  while (bucket < BUCKET_BOUNDS_NS.size() &&
+         nanoseconds > BUCKET_BOUNDS_NS[bucket])
+    ++bucket;
+  Bump(histogram.buckets[bucket], 1);
+  Bump(histogram.sum_ns, nanoseconds);
+  Bump(histogram.count, 1);
+}
+
+void Metrics::ObserveRun(MetricSeries series,
+                         const YOLORunTiming& timing) noexcept {
+  ObserveStage(series, MetricStage::kPreprocess, timing.preprocess_ns);
+  ObserveStage(series, MetricStage::kInference, timing.session_run_ns);
+  ObserveStage(series, MetricStage::kPostprocess,
+               timing.output_convert_ns + timing.decode_ns + timing.nms_ns);
+}
+
+void Metrics::ObserveRun(MetricSeries series,
+                         const OCRRunTiming& timing) noexcept {
+  ObserveStage(series, MetricStage::kPreprocess,
+               timing.det_preprocess_ns + timing.rec_preprocess_ns);
+  ObserveStage(series, MetricStage::kInference,
+               timing.det_run_ns + timing.rec_run_ns);
+  ObserveStage(series, MetricStage::kPostprocess,
+               timing.det_postprocess_ns + timing.rec_postprocess_ns);
+}
+
+void Metrics::CountRequest(MetricSeries series, bool error) noexcept {
+  auto& cells = impl_->LocalShard().Cells(series);
+  Bump(cells.requests, 1);
+  if (error) Bump(cells.errors, 1);
+}
+
+void Metrics::AddInFlight(int64_t delta) noexcept {
+  auto& in_flight = impl_->LocalShard().in_flight;
+  in_flight.store(in_flight.load(std::memory_order_relaxed) + delta,
+                  std::memory_order_relaxed);
+}
+
+void Metrics::AddGauge(std::string name, std::string help, std::string labels,
+                       GaugeFunc func, const void* owner) {
+  std::lock_guard lock{impl_->gauge_mutex};
+  impl_->gauges.emplace_back(Impl::Gauge{std::move(name), std::move(help),
+                                         std::move(labels), std::move(func),
+                                         owner, "gauge"});
+}
+
+void Metrics::AddCounter(std::string name, std::string help,
+                         std::string labels, GaugeFunc func,
+                         const void* owner) {
+  std::lock_guard lock{impl_->gauge_mutex};
+  impl_->gauges.emplace_back(Impl::Gauge{std::move(name), std::move(help),
+                                         std::move(labels), std::move(func),
+                                         owner, "counter"});
+}
+
+void Metrics::RemoveGauges(const void* owner) {
+  {
+    std::lock_guard lock{impl_->gauge_mutex};
+    std::erase_if(impl_->gauges, [owner](const Impl::Gauge& gauge) {
+      return gauge.owner == owner;
+    });
+  }
+  // 等待已复制了这些gauge的抓取求值结束
+  std::unique_lock render_lock{impl_->render_mutex};
+}
+
+std::string Metrics::Render() const {
+  struct Totals {
+    std::array<std::array<uint64_t, BUCKET_COUNT>, STAGE_COUNT> buckets{};
+    std::array<uint64_t, STAGE_COUNT> sum_ns{}, count{};
+    uint64_t requests{0}, errors{0};
+    bool present{false};
+  };
+  std::vector<std::pair<std::string, std::string>> labels;
+  std::vector<Totals> totals;
+  int64_t in_flight = 0;
+  {
+    std::lock_guard lock{impl_->mutex};
+    labels = impl_->series_labels;
+    totals.resize(labels.size());
+    for (const auto& shard : impl_->shards) {
+      in_flight += shard->in_flight.load(std::memory_order_relaxed);
+      for (size_t id = 0; id < labels.size(); ++id) {
+        const auto* cells = shard->series[id].load(std::memory_order_acquire);
+        if (!cells) continue;
+        auto& total = totals[id];
+        total.present = true;
+        total.requests += cells->requests.load(std::memory_order_relaxed);
+        total.errors += cells->errors.load(std::memory_order_relaxed);
+        for (size_t s = 0; s < STAGE_COUNT; ++s) {
+          const auto& histogram = cells->stages[s];
+          for (size_t b = 0; b < BUCKET_COUNT; ++b)
+            total.buckets[s][b] +=
+                histogram.buckets[b].load(std::memory_order_relaxed);
+          total.sum_ns[s] += histogram.sum_ns.load(std::memory_order_relaxed);
+          total.count[s] += histogram.count.load(std::memory_order_relaxed);
+        }
+      }
+    }
+  }
+  std::vector<std::string> series_labels(labels.size());
+  for (size_t id = 0; id < labels.size(); ++id)
+    series_labels[id] = std::format(R"(endpoint="{}",model="{}")",
+                                    EscapeLabel(labels[id].first),
+                                    EscapeLabel(labels[id].second));
+  std::string out;
+  out.reserve(16 * 1024);
+  out.append(
+      "# HELP vision_simple_requests_total Inference requests handled.\n"
+      "# TYPE vision_simple_requests_total counter\n");
+  for (size_t id = 0; id < totals.size(); ++id) {
+    if (!totals[id].present) continue;
+    out.append(std::format("vision_simple_requests_total{{{}}} {}\n",
+                           series_labels[id], totals[id].requests));
+  }
+  out.append(
+      "# HELP vision_simple_request_errors_total Inference requests that "
+      "failed.\n"
+      "# TYPE vision_simple_request_errors_total counter\n");
+  for (size_t id = 0; id < totals.size(); ++id) {
+    if (!totals[id].present) continue;
+    out.append(std::format("vision_simple_request_errors_total{{{}}} {}\n",
+                           series_labels[id], totals[id].errors));
+  }
+  out.append(
+      "# HELP vision_simple_stage_duration_seconds Time spent per request "
+      "stage.\n"
+      "# TYPE vision_simple_stage_duration_seconds histogram\n");
+  for (size_t id = 0; id < totals.size(); ++id) {
+    const auto& total = totals[id];
+    if (!total.present) continue;
+    for (size_t s = 0; s < STAGE_COUNT; ++s) {
+      if (total.count[s] == 0) continue;
+      const auto stage_labels =
+          std::format(R"({},stage="{}")", series_labels[id], STAGE_NAMES[s]);
+      uint64_t cumulative = 0;
+      for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+        cumulative += total.buckets[s][b];
+        const auto le =
+            b < BUCKET_LABELS.size() ? BUCKET_LABELS[b] : std::string_view{"+Inf"};
+        out.append(std::format(
+            "vision_simple_stage_duration_seconds_bucket{{{},le=\"{}\"}} {}\n",
+            stage_labels, le, cumulative));
+      }
+      out.append(std::format(
+          "vision_simple_stage_duration_seconds_sum{{{}}} {}\n", stage_labels,
+          static_cast<double>(total.sum_ns[s]) / 1e9));
+      out.append(
+          std::format("vision_simple_stage_duration_seconds_count{{{}}} {}\n",
+                      stage_labels, total.count[s]));
+    }
+  }
+  out.append(
+      "# HELP vision_simple_in_flight_requests Requests being processed.\n"
+      "# TYPE vision_simple_in_flight_requests gauge\n");
+  out.append(std::format("vision_simple_in_flight_requests {}\n", in_flight));
+  // gauge可能等待模型加载时独占的锁，复制后在gauge_mutex外求值，
+  // 不阻塞其他抓取和AddGauge
+  std::shared_lock render_lock{impl_->render_mutex};
+  std::vector<Impl::Gauge> gauges;
+  {
+    std::lock_guard gauge_lock{impl_->gauge_mutex};
+    gauges = impl_->gauges;
+  }
+  std::string_view last_name;
+  for (const auto& gauge : gauges) {
+    if (gauge.name != last_name) {
+      out.append(std::format("# HELP {} {}\n# TYPE {} {}\n", gauge.name,
+                             gauge.help, gauge.name, gauge.type));
+      last_name = gauge.name;
+    }
+    if (gauge.labels.empty())
+      out.append(std::format("{} {}\n", gauge.name, gauge.func()));
+    else
+      out.append(
+          std::format("{}{{{}}} {}\n", gauge.name, gauge.labels, gauge.func()));
+  }
+  return out;
+}
@@ -0,0 +1,211 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "LocalTransport.h"
+#include "TestCheck.h"
+using namespace vision_simple;
+
+namespace {
+// 返回覆盖整幅图片的一个结果，class_id为左上角像素的B通道
+class FakeYOLO final : public InferYOLO {
+  std::vector<std::string> class_names_{"fake"};
+
+ public:
+  YOLOVersion version() const noexcept override { return YOLOVersion::kV11; }
+  const std::vector<std::string>& class_names() const noexcept override {
+    return class_names_;
+  }
+  RunResult Run(const cv::Mat& image, float confidence_threshold,
+                YOLORunTiming*) noexcept override {
+    return YOLOFrameResult{{YOLOResult{
+        .class_id = image.at<cv::Vec3b>(0, 0)[0],
+        .bbox = {0, 0, image.cols, image.rows},
+        .confidence = confidence_threshold,
+        .class_name = class_names_[0]}}};
+  }
+  std::vector<std::string> EndProfiling() noexcept override { return {}; }
+};
+
+class FakeOCR final : public InferOCR {
+ public:
+  OCRModelType model_type() const noexcept override {
+    return OCRModelType::kPPOCRv4;
+  }
+  RunResult Run(const cv::Mat& image, float confidence_threshold,
+                OCRRunTiming*) noexcept override {
+    return OCRFrameResult{{OCRResult{.rect = {1, 2, image.cols - 1, 3},
+                                     .confidence = confidence_threshold,
+                                     .line = "hello"}}};
+  }
+  DetectResult Detect(const cv::Mat&, OCRRunTiming*) noexcept override {
+    return {};
+  }
+  RunResult Recognize(const cv::Mat&, std::span<const cv::Rect>, float,
+                      OCRRunTiming*) noexcept override {
+    return OCRFrameResult{};
+  }
+  std::vector<RunResult> RunBatch(std::span<const cv::Mat>, float,
+                                  OCRRunTiming*) noexcept override {
+    return {};
+  }
+  OCRRecCacheStats rec_cache_stats() const noexcept override { return {}; }
+  std::vector<std::string> EndProfiling() noexcept override { return {}; }
+};
+
+int Connect(const std::string& path) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+  if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool RoundTrip(int fd, const LocalRequest& request, LocalResponse& response) {
+  return send(fd, &request, sizeof(request), MSG_NOSIGNAL) ==
+             sizeof(request) &&
+         recv(fd, &response, sizeof(response), 0) == sizeof(response);
+}
+
+LocalRequest MakeRequest(LocalTask task, uint32_t slot, uint64_t sequence,
+                         std::string_view model) {
+  LocalRequest request{.magic = LOCAL_TRANSPORT_MAGIC,
+                       .slot = slot,
+                       .task = task,
+                       .pixel_format = LocalPixelFormat::kBGR24,
+                       .width = 32,
+                       .height = 16,
+                       .stride = 0,
+                       .confidence = 0.5f,
+                       .sequence = sequence,
+                       .model = {}};
+  std::memcpy(request.model, model.data(), model.size());
+  return request;
+}
+}  // namespace
+
+int main() {
+  FakeYOLO yolo;
+  FakeOCR ocr;
+  const auto suffix = std::to_string(getpid());
+  LocalTransportOptions options{
+      .socket_path = "/tmp/vision_simple_test_" + suffix + ".sock",
+      .shm_name = "/vision_simple_test_" + suffix,
+      .slot_count = 4,
+      .client_slots = 2,
+      .frame_slot_bytes = 64 * 1024,
+      .result_slot_bytes = 4096};
+  auto transport_result = LocalTransport::Create(
+      options,
+      [&yolo](const std::string& name)
+          -> VSResult<std::reference_wrapper<InferYOLO>> {
+        if (name != "fake")
+          return MK_VSERROR(VisionSimpleErrorCode::kModelError,
+                            "unable to find model: " + name);
+        return yolo;
+      },
+      [&ocr](const std::string&) -> VSResult<std::reference_wrapper<InferOCR>> {
+        return ocr;
+      });
+  CHECK(transport_result.has_value());
+  auto& transport = **transport_result;
+  transport.StartAsync();
+
+  const int fd = Connect(options.socket_path);
+  CHECK(fd >= 0);
+  LocalHello hello{};
+  CHECK(recv(fd, &hello, sizeof(hello), 0) == sizeof(hello));
+  CHECK(hello.magic == LOCAL_TRANSPORT_MAGIC);
+  CHECK(hello.slot_count == options.client_slots);
+
+  const int shm_fd = shm_open(options.shm_name.c_str(), O_RDWR, 0);
+  CHECK(shm_fd >= 0);
+  struct stat shm_stat{};
+  CHECK(fstat(shm_fd, &shm_stat) == 0);
+  auto* base = static_cast<uint8_t*>(mmap(nullptr, shm_stat.st_size,
+                                          PROT_READ | PROT_WRITE, MAP_SHARED,
+                                          shm_fd, 0));
+  CHECK(base != MAP_FAILED);
+  const auto& ring = *reinterpret_cast<const LocalRingHeader*>(base);
+  CHECK(ring.magic == LOCAL_TRANSPORT_MAGIC);
+  CHECK(ring.slot_count == options.slot_count);
+  const uint32_t slot = hello.first_slot + 1;
+  auto* frame = base + ring.frame_ring_offset + slot * ring.frame_slot_bytes;
+  const auto* result =
+      base + ring.result_ring_offset + slot * ring.result_slot_bytes;
+  const auto& result_header =
+      *reinterpret_cast<const LocalResultHeader*>(result);
+
+  // YOLO：帧直接写入slot，结果从同下标的result slot读取
+  std::memset(frame, 7, 32 * 16 * 3);
+  LocalResponse response{};
+  CHECK(RoundTrip(fd, MakeRequest(LocalTask::kYOLO, slot, 1, "fake"),
+                  response));
+  CHECK(response.code == VisionSimpleErrorCode::kOK);
+  CHECK(response.sequence == 1 && response.slot == slot);
+  CHECK(response.count == 1);
+  CHECK(result_header.kind == LocalResultKind::kYOLO);
+  const auto& record = *reinterpret_cast<const LocalYOLORecord*>(
+      result + sizeof(LocalResultHeader));
+  CHECK(record.class_id == 7);
+  CHECK(record.confidence == 0.5f);
+  CHECK(record.bbox[2] == 32 && record.bbox[3] == 16);
+
+  // OCR：记录之后是文本区
+  CHECK(RoundTrip(fd, MakeRequest(LocalTask::kOCR, slot, 2, "fake"),
+                  response));
+  CHECK(response.code == VisionSimpleErrorCode::kOK);
+  CHECK(result_header.kind == LocalResultKind::kOCR);
+  CHECK(result_header.count == 1 && result_header.text_bytes == 5);
+  const auto& ocr_record = *reinterpret_cast<const LocalOCRRecord*>(
+      result + sizeof(LocalResultHeader));
+  const auto* text = reinterpret_cast<const char*>(
+      result + sizeof(LocalResultHeader) + sizeof(LocalOCRRecord));
+  CHECK(std::string_view(text + ocr_record.text_offset,
+                         ocr_record.text_size) == "hello");
+  CHECK(ocr_record.bbox[0] == 1 && ocr_record.bbox[2] == 31);
+
+  // 未知模型：结果slot中为错误信息
+  CHECK(RoundTrip(fd, MakeRequest(LocalTask::kYOLO, slot, 3, "missing"),
+                  response));
+  CHECK(response.code == VisionSimpleErrorCode::kModelError);
+  CHECK(result_header.kind == LocalResultKind::kError);
+
+  // 不属于该连接的slot不会被写入
+  CHECK(RoundTrip(fd,
+                  MakeRequest(LocalTask::kYOLO,
+                              hello.first_slot + hello.slot_count, 4, "fake"),
+                  response));
+  CHECK(response.code == VisionSimpleErrorCode::kParameterError);
+
+  // 4个slot每个连接2个，第三个连接拿不到slot
+  const int second = Connect(options.socket_path);
+  CHECK(second >= 0);
+  CHECK(recv(second, &hello, sizeof(hello), 0) == sizeof(hello));
+  CHECK(hello.slot_count == options.client_slots);
+  const int third = Connect(options.socket_path);
+  CHECK(third >= 0);
+  CHECK(recv(third, &hello, sizeof(hello), 0) == sizeof(hello));
+  CHECK(hello.slot_count == 0);
+
+  close(third);
+  close(second);
+  close(fd);
+  munmap(base, shm_stat.st_size);
+  close(shm_fd);
+  transport.Stop();
+  std::cout << "ok" << std::endl;
+  return 0;
+}
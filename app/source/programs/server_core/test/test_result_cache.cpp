@@ -0,0 +1,93 @@
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "ResultCache.h"
+#include "TestCheck.h"
+using namespace vision_simple;
+
+int main() {
+  // 任务、模型、阈值或数据不同时键不同
+  const auto key = MakeResultCacheKey("yolo", "a", 0.5f, "image-1");
+  CHECK(key == MakeResultCacheKey("yolo", "a", 0.5f, "image-1"));
+  CHECK(!(key == MakeResultCacheKey("ocr", "a", 0.5f, "image-1")));
+  CHECK(!(key == MakeResultCacheKey("yolo", "b", 0.5f, "image-1")));
+  CHECK(!(key == MakeResultCacheKey("yolo", "a", 0.6f, "image-1")));
+  CHECK(!(key == MakeResultCacheKey("yolo", "a", 0.5f, "image-2")));
+  CHECK(key.hash != key.hash2);
+
+  ResultCache<std::string> cache{2, 1024,
+                                 [](const std::string& v) { return v.size(); }};
+  int computed = 0;
+  auto compute = [&computed](std::string value) {
+    return [&computed, value] {
+      ++computed;
+      return VSResult<std::string>{value};
+    };
+  };
+
+  // 未命中时计算并缓存，之后命中
+  auto result = cache.GetOrCompute(key, compute("a"));
+  CHECK(result && *result == "a");
+  result = cache.GetOrCompute(key, compute("x"));
+  CHECK(result && *result == "a");
+  CHECK(computed == 1);
+  auto stats = cache.stats();
+  CHECK(stats.misses == 1 && stats.hits == 1 && stats.entries == 1);
+  CHECK(stats.bytes == 1);
+
+  // 失败的结果不缓存
+  const auto failing = MakeResultCacheKey("yolo", "a", 0.5f, "image-2");
+  result = cache.GetOrCompute(failing, [&computed]() -> VSResult<std::string> {
+    ++computed;
+    return MK_VSERROR(VisionSimpleErrorCode::kRuntimeError, "failed");
+  });
+  CHECK(!result && result.error().code == VisionSimpleErrorCode::kRuntimeError);
+  result = cache.GetOrCompute(failing, compute("b"));
+  CHECK(result && *result == "b");
+  CHECK(computed == 3);
+
+  // 超出条目数时淘汰最久未使用的
+  cache.GetOrCompute(key, compute("x"));
+  const auto third = MakeResultCacheKey("yolo", "a", 0.5f, "image-3");
+  cache.GetOrCompute(third, compute("c"));
+  stats = cache.stats();
+  CHECK(stats.evictions == 1 && stats.entries == 2);
+  result = cache.GetOrCompute(failing, compute("d"));
+  CHECK(result && *result == "d");
+  CHECK(cache.stats().misses == 5);
+
+  // 相同键的并发请求等待正在进行的计算，只计算一次
+  const auto shared = MakeResultCacheKey("ocr", "a", 0.5f, "image-4");
+  std::promise<void> started, release;
+  auto release_future = release.get_future();
+  std::atomic<int> shared_computed{0};
+  std::thread first{[&] {
+    cache.GetOrCompute(shared, [&] {
+      ++shared_computed;
+      started.set_value();
+      release_future.wait();
+      return VSResult<std::string>{"e"};
+    });
+  }};
+  started.get_future().wait();
+  auto second = std::async(std::launch::async, [&] {
+    return cache.GetOrCompute(shared, [&] {
+      ++shared_computed;
+      return VSResult<std::string>{"f"};
+    });
+  });
+  while (cache.stats().coalesced == 0) std::this_thread::yield();
+  CHECK(second.wait_for(std::chrono::milliseconds(50)) ==
+        std::future_status::timeout);
+  release.set_value();
+  first.join();
+  result = second.get();
+  CHECK(result && *result == "e");
+  CHECK(shared_computed == 1);
+  CHECK(cache.stats().coalesced == 1);
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,9 @@
+local target_name = "server_core"
+local kind = "static"
+local group_name = "program"
+local pkgs = { "log4cplus" }
+local deps = { "runtime" }
+local syslinks = {}
+local function callback()
+end
+CreateTarget(target_name, kind, os.scriptdir(), group_name, pkgs, deps, syslinks, callback)
\ No newline at end of file
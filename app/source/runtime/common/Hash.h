@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "config.h"
+
+namespace vision_simple {
+/**
+ * 64位非加密哈希(XXH64)，用于缓存键
+ * @param data 待哈希的数据
+ * @param seed 种子
+ */
+VISION_SIMPLE_API uint64_t Hash64(std::span<const uint8_t> data,
+                                  uint64_t seed = 0) noexcept;
+
+inline uint64_t Hash64(std::string_view data, uint64_t seed = 0) noexcept {
+  return Hash64(std::span{reinterpret_cast<const uint8_t*>(data.data()),
+                          data.size()},
+                seed);
+}
+
+constexpr uint64_t HashCombine(uint64_t seed, uint64_t value) noexcept {
+  return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+}
+}  // namespace vision_simple
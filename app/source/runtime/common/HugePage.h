@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+#include "config.h"
+
+namespace vision_simple {
+enum class HugePageMode : uint8_t {
+  // madvise(MADV_HUGEPAGE)，由内核透明大页合并
+  kTransparent = 0,
+  // 优先使用预留的大页(MAP_HUGETLB/MEM_LARGE_PAGES)，失败时退回kTransparent
+  kExplicit,
+};
+
+struct HugePageStats {
+  // 已映射的大块内存，包含缓存中空闲的部分
+  uint64_t mapped_bytes;
+  uint64_t cached_bytes;
+  uint64_t cache_hits;
+  uint64_t cache_misses;
+};
+
+/**
+ * 进程内共享的大页内存池，返回的地址按ALIGNMENT对齐
+ * 不小于HUGE_PAGE_SIZE的请求按2MB粒度映射并尝试使用大页，
+ * 释放后缓存以供同尺寸请求复用，缓存超过上限时归还最早缓存的块；
+ * 较小的请求以及Configure之前的所有请求直接走对齐的operator new
+ */
+class VISION_SIMPLE_API HugePagePool {
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+
+  HugePagePool();
+
+ public:
+  // 映射粒度，kExplicit映射的也是该尺寸的大页
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+  static constexpr size_t ALIGNMENT = 64;
+  static constexpr size_t DEFAULT_MAX_CACHED_BYTES = 256 * 1024 * 1024;
+
+  static HugePagePool& Instance() noexcept;
+  ~HugePagePool();
+  HugePagePool(const HugePagePool&) = delete;
+  HugePagePool& operator=(const HugePagePool&) = delete;
+
+  /**
+   * @throw std::bad_alloc 映射失败
+   */
+  void* Allocate(size_t size);
+  void Free(void* ptr) noexcept;
+  /**
+   * 启用大页映射，作用于整个进程，之后的分配按新的配置进行
+   * @param max_cached_bytes 空闲缓存上限，0表示释放后立即归还系统
+   */
+  void Configure(HugePageMode mode, size_t max_cached_bytes) noexcept;
+  bool enabled() const noexcept;
+  // 归还所有缓存的空闲块
+  void Trim() noexcept;
+  HugePageStats stats() const noexcept;
+};
+
+/**
+ * 从HugePagePool分配的标准库分配器，用于推理输入缓冲区，池未开启时退回堆分配
+ */
+template <typename T>
+struct HugePageAllocator {
+  using value_type = T;
+
+  HugePageAllocator() noexcept = default;
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>&) noexcept {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(HugePagePool::Instance().Allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, size_t) noexcept {
+    HugePagePool::Instance().Free(ptr);
+  }
+
+  template <typename U>
+  bool operator==(const HugePageAllocator<U>&) const noexcept {
+    return true;
+  }
+};
+}  // namespace vision_simple
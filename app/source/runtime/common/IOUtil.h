@@ -3,6 +3,7 @@
 #include <memory>
 #include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
 #include "config.h"
@@ -26,6 +27,42 @@ namespace vision_simple
         }
     };
 
+    /**
+     * 只读打开并映射整个文件，数据由页缓存提供，不额外复制
+     * 映射为写时复制，对span的写入不会影响文件
+     */
+    class VISION_SIMPLE_API MappedFile
+    {
+        uint8_t* data_{nullptr};
+        size_t size_{0};
+#ifdef _WIN32
+        void* mapping_{nullptr};
+#endif
+
+        void Close() noexcept;
+
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        /**
+         * @return 空文件返回size为0的MappedFile
+         */
+        static std::expected<MappedFile, VisionSimpleError> Open(const std::string& path) noexcept;
+
+        size_t size() const noexcept { return size_; }
+        std::span<uint8_t> span() const noexcept { return {data_, size_}; }
+
+        std::string_view view() const noexcept
+        {
+            return {reinterpret_cast<const char*>(data_), size_};
+        }
+    };
+
     VISION_SIMPLE_API std::expected<DataBuffer<uint8_t>, VisionSimpleError> ReadAll(const std::string& path) noexcept;
     VISION_SIMPLE_API std::expected<std::string, VisionSimpleError> ReadAllString(const std::string& path) noexcept;
     VISION_SIMPLE_API std::expected<std::vector<std::string>, VisionSimpleError> ReadAllLines(const std::string& path) noexcept;
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace vision_simple {
+/**
+ * 按条目数和字节数双重限制的LRU缓存，非线程安全，由调用者加锁
+ * @tparam K 键
+ * @tparam V 值
+ * @tparam Hash 键的哈希函数
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class LRUCache {
+  struct Entry {
+    K key;
+    V value;
+    size_t bytes;
+  };
+
+  size_t max_entries_, max_bytes_;
+  size_t bytes_{0};
+  size_t evictions_{0};
+  std::list<Entry> entries_;
+  std::unordered_map<K, typename std::list<Entry>::iterator, Hash> index_;
+
+  void Evict() {
+    while (!entries_.empty() &&
+           (entries_.size() > max_entries_ || bytes_ > max_bytes_)) {
+      auto& last = entries_.back();
+      bytes_ -= last.bytes;
+      index_.erase(last.key);
+      entries_.pop_back();
+      ++evictions_;
+    }
+  }
+
+ public:
+  LRUCache(size_t max_entries, size_t max_bytes)
+      : max_entries_(max_entries), max_bytes_(max_bytes) {
+    index_.reserve(max_entries);
+  }
+
+  /**
+   * 查找并将命中的条目移到队首
+   * @return 命中时返回值的指针，否则nullptr；指针在下一次Put前有效
+   */
+  V* Get(const K& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) return nullptr;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->value;
+  }
+
+  /**
+   * 插入或替换条目，超出限制时淘汰最久未使用的条目
+   * @param bytes 该条目占用的字节数估计
+   */
+  void Put(const K& key, V value, size_t bytes) {
+    if (bytes > max_bytes_ || max_entries_ == 0) return;
+    if (auto it = index_.find(key); it != index_.end()) {
+      bytes_ -= it->second->bytes;
+      it->second->value = std::move(value);
+      it->second->bytes = bytes;
+      entries_.splice(entries_.begin(), entries_, it->second);
+    } else {
+      entries_.emplace_front(Entry{key, std::move(value), bytes});
+      index_.emplace(key, entries_.begin());
+    }
+    bytes_ += bytes;
+    Evict();
+  }
+
+  void Clear() noexcept {
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+  }
+
+  size_t size() const noexcept { return entries_.size(); }
+  size_t bytes() const noexcept { return bytes_; }
+  size_t evictions() const noexcept { return evictions_; }
+  size_t max_entries() const noexcept { return max_entries_; }
+  size_t max_bytes() const noexcept { return max_bytes_; }
+};
+}  // namespace vision_simple
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include "config.h"
+
+namespace vision_simple {
+/**
+ * 固定线程数的线程池
+ */
+class VISION_SIMPLE_API ThreadPool {
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+
+ public:
+  explicit ThreadPool(size_t threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t size() const noexcept;
+  void Submit(std::function<void()> task);
+  /**
+   * 并行执行count个任务，调用线程也参与执行，全部完成后返回
+   * @param func func(task_index, worker_index)，worker_index范围为[0,size()]，
+   * 0为调用线程，同一worker_index不会被并发使用
+   */
+  void ParallelFor(size_t count,
+                   const std::function<void(size_t, size_t)>& func);
+};
+}  // namespace vision_simple
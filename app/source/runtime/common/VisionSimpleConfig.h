@@ -1,5 +1,6 @@
 #pragma once
 #include <expected>
+#include <map>
 #include <string>
 #include <vector>
 #include <memory>
@@ -13,12 +14,34 @@ namespace vision_simple
     {
         std::string name, version;
         std::string path;
+        // ORT session调优参数，如session_preset、intra_op_threads
+        std::map<std::string, std::string> session;
     };
 
     struct OCRModelInfo
     {
         std::string name, version;
         std::string det_path, rec_path, char_dict_path;
+        // rec单次推理的最大文本框数，1为逐框推理
+        uint32_t rec_batch_size{8};
+        // rec并行worker线程数，0为在调用线程串行执行
+        uint32_t rec_threads{0};
+        // rec输入的最大宽度，超出的文本行分段识别，0为不限制
+        uint32_t rec_max_width{960};
+        // rec结果缓存条目数，视频等重复画面可开启，0为不启用
+        uint32_t rec_cache_entries{0};
+        // det概率图二值化阈值
+        float det_threshold{0.3f};
+        // 文本框内平均概率低于该值时丢弃，0为不过滤
+        float det_box_threshold{0.6f};
+        // det输入边长限制，0为按原图尺寸推理
+        uint32_t det_limit_side_len{960};
+        // kMax:最长边超过限制时缩小 kMin:最短边小于限制时放大
+        std::string det_limit_type{"kMax"};
+        // 多图请求中det输入尺寸相同的图片单次det推理的最大数量
+        uint32_t det_batch_size{4};
+        // det和rec的ORT session调优参数
+        std::map<std::string, std::string> session;
     };
 
     struct ModelConfig
@@ -0,0 +1,220 @@
+#include "HugePage.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+// 较旧的libc只定义了MAP_HUGE_SHIFT
+#if defined(MAP_HUGE_SHIFT) && !defined(MAP_HUGE_2MB)
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#endif
+
+using namespace vision_simple;
+
+namespace {
+// 位于每个块的起始处，返回给调用方的地址紧随其后
+struct BlockHeader {
+  void* base;
+  // 0表示由operator new分配
+  size_t mapped_size;
+};
+static_assert(sizeof(BlockHeader) <= HugePagePool::ALIGNMENT);
+
+struct CachedBlock {
+  void* base;
+  size_t size;
+};
+
+constexpr size_t RoundUp(size_t size, size_t granularity) noexcept {
+  return (size + granularity - 1) / granularity * granularity;
+}
+
+void* MapHugePages(size_t size, HugePageMode mode) noexcept {
+#ifdef _WIN32
+  if (mode == HugePageMode::kExplicit) {
+    // 需要SeLockMemoryPrivilege，没有权限时退回普通页
+    const auto large_page = GetLargePageMinimum();
+    if (large_page && size % large_page == 0)
+      if (auto ptr = VirtualAlloc(nullptr, size,
+                                  MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                  PAGE_READWRITE))
+        return ptr;
+  }
+  return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+  constexpr auto page = HugePagePool::HUGE_PAGE_SIZE;
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_2MB)
+  if (mode == HugePageMode::kExplicit) {
+    // 依赖vm.nr_hugepages预留的大页，不足时退回透明大页。显式指定2MB，
+    // 默认大页为1GB时映射长度会被取整，按size munmap会泄漏
+    auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB,
+                    -1, 0);
+    if (ptr != MAP_FAILED) return ptr;
+  }
+#endif
+  // 多映射一个大页再裁掉首尾，使区间对齐到2MB边界，透明大页才能整页生效
+  const size_t reserve = size + page;
+  auto raw = mmap(nullptr, reserve, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) return nullptr;
+  const auto address = reinterpret_cast<uintptr_t>(raw);
+  const auto aligned = RoundUp(address, page);
+  const size_t head = aligned - address;
+  const size_t tail = reserve - head - size;
+  if (head) munmap(raw, head);
+  if (tail) munmap(reinterpret_cast<void*>(aligned + size), tail);
+  auto ptr = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+  madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+  return ptr;
+#endif
+}
+
+void UnmapHugePages(void* ptr, size_t size) noexcept {
+#ifdef _WIN32
+  VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+  munmap(ptr, size);
+#endif
+}
+
+void* AttachHeader(void* base, size_t mapped_size) noexcept {
+  new (base) BlockHeader{base, mapped_size};
+  return static_cast<uint8_t*>(base) + HugePagePool::ALIGNMENT;
+}
+
+const BlockHeader& HeaderOf(void* ptr) noexcept {
+  return *reinterpret_cast<const BlockHeader*>(static_cast<uint8_t*>(ptr) -
+                                               HugePagePool::ALIGNMENT);
+}
+}  // namespace
+
+struct vision_simple::HugePagePool::Impl {
+  mutable std::mutex mutex;
+  // Configure之前不映射大页，未开启大页的进程中分配器等同于operator new
+  std::atomic<bool> enabled{false};
+  HugePageMode mode{HugePageMode::kTransparent};
+  size_t max_cached_bytes{DEFAULT_MAX_CACHED_BYTES};
+  // 尾部为最近释放的块
+  std::deque<CachedBlock> cached;
+  uint64_t mapped_bytes{0}, cached_bytes{0};
+  uint64_t cache_hits{0}, cache_misses{0};
+
+  // 从最早缓存的块开始归还，直到缓存不超过limit，调用方在锁外解除映射
+  void ShrinkLocked(size_t limit, std::vector<CachedBlock>& released) {
+    while (cached_bytes > limit) {
+      auto block = cached.front();
+      cached.pop_front();
+      cached_bytes -= block.size;
+      mapped_bytes -= block.size;
+      released.emplace_back(block);
+    }
+  }
+
+  static void Release(const std::vector<CachedBlock>& released) noexcept {
+    for (const auto& block : released) UnmapHugePages(block.base, block.size);
+  }
+};
+
+HugePagePool::HugePagePool() : impl_(std::make_unique<Impl>()) {}
+
+HugePagePool::~HugePagePool() { Trim(); }
+
+HugePagePool& HugePagePool::Instance() noexcept {
+  // 不析构：静态对象析构之后仍可能有缓冲区被释放
+  static auto* instance = new HugePagePool();
+  return *instance;
+}
+
+void* HugePagePool::Allocate(size_t size) {
+  const size_t total = size + ALIGNMENT;
+  if (total < HUGE_PAGE_SIZE || !enabled())
+    return AttachHeader(::operator new(total, std::align_val_t{ALIGNMENT}), 0);
+  const size_t mapped_size = RoundUp(total, HUGE_PAGE_SIZE);
+  void* base = nullptr;
+  HugePageMode mode;
+  {
+    std::lock_guard lock{impl_->mutex};
+    // 优先复用最近释放的块，其页表项更可能仍在TLB中
+    auto& cached = impl_->cached;
+    for (auto it = cached.rbegin(); it != cached.rend(); ++it) {
+      if (it->size != mapped_size) continue;
+      base = it->base;
+      cached.erase(std::next(it).base());
+      impl_->cached_bytes -= mapped_size;
+      break;
+    }
+    if (base)
+      ++impl_->cache_hits;
+    else
+      ++impl_->cache_misses;
+    mode = impl_->mode;
+  }
+  if (!base) {
+    base = MapHugePages(mapped_size, mode);
+    if (!base) throw std::bad_alloc();
+    std::lock_guard lock{impl_->mutex};
+    impl_->mapped_bytes += mapped_size;
+  }
+  return AttachHeader(base, mapped_size);
+}
+
+void HugePagePool::Free(void* ptr) noexcept {
+  if (!ptr) return;
+  const auto header = HeaderOf(ptr);
+  if (header.mapped_size == 0) {
+    ::operator delete(header.base, std::align_val_t{ALIGNMENT});
+    return;
+  }
+  std::vector<CachedBlock> released;
+  {
+    std::lock_guard lock{impl_->mutex};
+    impl_->cached.push_back({header.base, header.mapped_size});
+    impl_->cached_bytes += header.mapped_size;
+    impl_->ShrinkLocked(impl_->max_cached_bytes, released);
+  }
+  Impl::Release(released);
+}
+
+void HugePagePool::Configure(HugePageMode mode,
+                             size_t max_cached_bytes) noexcept {
+  std::vector<CachedBlock> released;
+  {
+    std::lock_guard lock{impl_->mutex};
+    impl_->mode = mode;
+    impl_->max_cached_bytes = max_cached_bytes;
+    impl_->ShrinkLocked(max_cached_bytes, released);
+  }
+  impl_->enabled.store(true, std::memory_order_release);
+  Impl::Release(released);
+}
+
+bool HugePagePool::enabled() const noexcept {
+  return impl_->enabled.load(std::memory_order_acquire);
+}
+
+void HugePagePool::Trim() noexcept {
+  std::vector<CachedBlock> released;
+  {
+    std::lock_guard lock{impl_->mutex};
+    impl_->ShrinkLocked(0, released);
+  }
+  Impl::Release(released);
+}
+
+HugePageStats HugePagePool::stats() const noexcept {
+  std::lock_guard lock{impl_->mutex};
+  return HugePageStats{
+      .mapped_bytes = impl_->mapped_bytes,
+      .cached_bytes = impl_->cached_bytes,
+      .cache_hits = impl_->cache_hits,
+      .cache_misses = impl_->cache_misses,
+  };
+}
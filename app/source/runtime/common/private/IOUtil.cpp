@@ -1,7 +1,114 @@
 ﻿#include "IOUtil.h"
 
-#include <sstream>
+#include <algorithm>
 #include <filesystem>
+#include <iterator>
+#include <utility>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+vision_simple::MappedFile::~MappedFile() { Close(); }
+
+vision_simple::MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0))
+#ifdef _WIN32
+      ,
+      mapping_(std::exchange(other.mapping_, nullptr))
+#endif
+{
+}
+
+vision_simple::MappedFile& vision_simple::MappedFile::operator=(
+    MappedFile&& other) noexcept {
+  if (this != &other) {
+    Close();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+    mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+  }
+  return *this;
+}
+
+void vision_simple::MappedFile::Close() noexcept {
+#ifdef _WIN32
+  if (data_) UnmapViewOfFile(data_);
+  if (mapping_) CloseHandle(mapping_);
+  mapping_ = nullptr;
+#else
+  if (data_) munmap(data_, size_);
+#endif
+  data_ = nullptr;
+  size_ = 0;
+}
+
+std::expected<vision_simple::MappedFile, vision_simple::VisionSimpleError>
+vision_simple::MappedFile::Open(const std::string& path) noexcept {
+  MappedFile file;
+#ifdef _WIN32
+  const auto wpath = std::filesystem::path(path).wstring();
+  HANDLE handle =
+      CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (handle == INVALID_HANDLE_VALUE)
+    return MK_VSERROR(VisionSimpleErrorCode::kIOError,
+                      std::format("unable to open file '{}'", path));
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(handle, &size)) {
+    CloseHandle(handle);
+    return MK_VSERROR(VisionSimpleErrorCode::kIOError,
+                      std::format("unable to stat file '{}'", path));
+  }
+  if (size.QuadPart == 0) {
+    CloseHandle(handle);
+    return file;
+  }
+  file.mapping_ =
+      CreateFileMappingW(handle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  CloseHandle(handle);
+  if (!file.mapping_)
+    return MK_VSERROR(VisionSimpleErrorCode::kIOError,
+                      std::format("unable to map file '{}'", path));
+  file.data_ =
+      static_cast<uint8_t*>(MapViewOfFile(file.mapping_, FILE_MAP_COPY, 0, 0, 0));
+  if (!file.data_)
+    return MK_VSERROR(VisionSimpleErrorCode::kIOError,
+                      std::format("unable to map file '{}'", path));
+  file.size_ = static_cast<size_t>(size.QuadPart);
+#else
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return MK_VSERROR(VisionSimpleErrorCode::kIOError,
+                      std::format("unable to open file '{}'", path));
+  struct stat st {};
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return MK_VSERROR(VisionSimpleErrorCode::kIOError,
+                      std::format("unable to stat file '{}'", path));
+  }
+  if (st.st_size == 0) {
+    close(fd);
+    return file;
+  }
+  void* data = mmap(nullptr, static_cast<size_t>(st.st_size),
+                    PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return MK_VSERROR(VisionSimpleErrorCode::kIOError,
+                      std::format("unable to map file '{}'", path));
+  file.data_ = static_cast<uint8_t*>(data);
+  file.size_ = static_cast<size_t>(st.st_size);
+#endif
+  return file;
+}
 
 std::expected<vision_simple::DataBuffer<unsigned char>,
               vision_simple::VisionSimpleError>
@@ -19,53 +126,44 @@ vision_simple::ReadAll(const std::string& path) noexcept {
                           std::format("file:{} is empty,size:{}", path, size)});
   }
   ifs.seekg(std::ios::beg);
-  auto buffer = std::make_unique<uint8_t[]>(size);
+  // 随后整体覆盖，不需要清零
+  auto buffer = std::make_unique_for_overwrite<uint8_t[]>(size);
   ifs.read(reinterpret_cast<char*>(buffer.get()), static_cast<long long>(size));
   return DataBuffer{std::move(buffer), size};
 }
 
 std::expected<std::string, vision_simple::VisionSimpleError>
 vision_simple::ReadAllString(const std::string& path) noexcept {
-  if (!std::filesystem::exists(path)) {
-    return std::unexpected(
-        VisionSimpleError{VisionSimpleErrorCode::kIOError,
-                          std::format("file not exists '{}'", path)});
-  }
-  std::ifstream file(path, std::ios::binary);
-  if (!file) {
-    return std::unexpected(
-        VisionSimpleError{VisionSimpleErrorCode::kIOError,
-                          std::format("unable to open file '{}'", path)});
-  }
-  std::stringstream file_str;
-  std::string line;
-  // TODO: optimize
-  while (std::getline(file, line)) {
-    std::string result;
-    for (char c : line) {
-      if (c != '\r') result.push_back(c);
-    }
-    file_str << std::format("{}\n", result);
-  }
-  return file_str.str();
+  auto file = MappedFile::Open(path);
+  if (!file) return std::unexpected(std::move(file.error()));
+  // 去掉\r，非空文件统一以\n结尾
+  const auto data = file->view();
+  std::string result;
+  result.reserve(data.size() + 1);
+  std::ranges::copy_if(data, std::back_inserter(result),
+                       [](char c) { return c != '\r'; });
+  if (!data.empty() && data.back() != '\n') result.push_back('\n');
+  return result;
 }
 
 std::expected<std::vector<std::string>, vision_simple::VisionSimpleError>
 vision_simple::ReadAllLines(const std::string& path) noexcept {
-  std::ifstream ifs(path, std::ios::binary);
-  if (!ifs) {
+  auto file = MappedFile::Open(path);
+  if (!file) {
     return MK_VSERROR(VisionSimpleErrorCode::kIOError,
                       std::format("Unable to open file:{}", path));
   }
   std::vector<std::string> lines;
-  std::string line;
-  while (std::getline(ifs, line)) {
-    std::string result;
+  auto data = file->view();
+  while (!data.empty()) {
+    const auto end = data.find('\n');
+    const auto line = data.substr(0, end);
+    auto& result = lines.emplace_back();
     result.reserve(line.size());
-    for (char c : line) {
-      if (c != '\r') result.push_back(c);
-    }
-    lines.emplace_back(std::move(result));
+    std::ranges::copy_if(line, std::back_inserter(result),
+                         [](char c) { return c != '\r'; });
+    if (end == std::string_view::npos) break;
+    data.remove_prefix(end + 1);
   }
   return lines;
 }
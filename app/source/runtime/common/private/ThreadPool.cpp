@@ -0,0 +1,91 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace vision_simple;
+
+struct vision_simple::ThreadPool::Impl {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::function<void()>> tasks;
+  bool stopping{false};
+  std::vector<std::thread> threads;
+
+  void Worker() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) return;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+};
+
+ThreadPool::ThreadPool(size_t threads) : impl_(std::make_unique<Impl>()) {
+  impl_->threads.reserve(threads);
+  for (size_t i = 0; i < threads; ++i)
+    impl_->threads.emplace_back([this] { impl_->Worker(); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock{impl_->mutex};
+    impl_->stopping = true;
+  }
+  impl_->cv.notify_all();
+  for (auto& thread : impl_->threads) thread.join();
+}
+
+size_t ThreadPool::size() const noexcept { return impl_->threads.size(); }
+
+void ThreadPool::Submit(std::function<void()> task) {
+  {
+    std::lock_guard lock{impl_->mutex};
+    impl_->tasks.emplace_back(std::move(task));
+  }
+  impl_->cv.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count,
+                             const std::function<void(size_t, size_t)>& func) {
+  if (count == 0) return;
+  const size_t helpers = std::min(size(), count - 1);
+  if (helpers == 0) {
+    for (size_t i = 0; i < count; ++i) func(i, 0);
+    return;
+  }
+  struct State {
+    std::atomic<size_t> next{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t running;
+  } state;
+  state.running = helpers;
+  auto drain = [&state, &func, count](size_t worker) {
+    for (size_t i = state.next.fetch_add(1); i < count;
+         i = state.next.fetch_add(1))
+      func(i, worker);
+  };
+  for (size_t worker = 1; worker <= helpers; ++worker) {
+    Submit([&state, &drain, worker] {
+      drain(worker);
+      std::lock_guard lock{state.mutex};
+      if (--state.running == 0) state.cv.notify_one();
+    });
+  }
+  drain(0);
+  // 等待所有helper退出，state和func在栈上
+  std::unique_lock lock{state.mutex};
+  state.cv.wait(lock, [&state] { return state.running == 0; });
+}
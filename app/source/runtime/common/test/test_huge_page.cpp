@@ -0,0 +1,54 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "HugePage.h"
+#include "TestCheck.h"
+using namespace vision_simple;
+
+int main() {
+  constexpr size_t MB = 1024 * 1024;
+  auto& pool = HugePagePool::Instance();
+  // 未开启时不映射大页
+  CHECK(!pool.enabled());
+  auto unmapped = pool.Allocate(5 * MB);
+  CHECK(pool.stats().mapped_bytes == 0);
+  pool.Free(unmapped);
+  CHECK(pool.stats().cached_bytes == 0);
+  pool.Configure(HugePageMode::kTransparent, 8 * MB);
+  CHECK(pool.enabled());
+  auto aligned = [](void* ptr) {
+    return reinterpret_cast<uintptr_t>(ptr) % HugePagePool::ALIGNMENT == 0;
+  };
+
+  auto small = pool.Allocate(100);
+  CHECK(aligned(small));
+  std::memset(small, 1, 100);
+  pool.Free(small);
+
+  // 5MB按2MB粒度映射为6MB，释放后进入缓存并被同尺寸请求复用
+  auto large = pool.Allocate(5 * MB);
+  CHECK(aligned(large));
+  std::memset(large, 1, 5 * MB);
+  CHECK(pool.stats().mapped_bytes == 6 * MB);
+  pool.Free(large);
+  CHECK(pool.stats().cached_bytes == 6 * MB);
+  auto reused = pool.Allocate(5 * MB);
+  CHECK(reused == large);
+  CHECK(pool.stats().cache_hits == 1);
+
+  // 超出缓存上限的块在释放时归还
+  auto other = pool.Allocate(7 * MB);
+  pool.Free(reused);
+  pool.Free(other);
+  CHECK(pool.stats().cached_bytes <= 8 * MB);
+  pool.Trim();
+  CHECK(pool.stats().mapped_bytes == 0);
+
+  std::vector<float, HugePageAllocator<float>> buffer(MB, 1.f);
+  CHECK(aligned(buffer.data()));
+  CHECK(pool.stats().mapped_bytes == 6 * MB);
+  std::cout << "ok" << std::endl;
+  return 0;
+}
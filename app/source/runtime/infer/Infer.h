@@ -37,6 +37,97 @@ enum class InferEP:uint8_t {
 
 using InferArgs = std::unordered_map<std::string, std::string>;
 
+// InferArgs中的ORT session调优键，模型的session配置覆盖context的配置
+constexpr std::string_view INFER_ARG_KEY_SESSION_PRESET{"session_preset"};
+constexpr std::string_view INFER_ARG_KEY_INTRA_OP_THREADS{"intra_op_threads"};
+constexpr std::string_view INFER_ARG_KEY_INTER_OP_THREADS{"inter_op_threads"};
+// "1"/"0"，同时作用于intra-op和inter-op线程池
+constexpr std::string_view INFER_ARG_KEY_ALLOW_SPINNING{"allow_spinning"};
+// ORT_SEQUENTIAL/ORT_PARALLEL
+constexpr std::string_view INFER_ARG_KEY_EXECUTION_MODE{"execution_mode"};
+constexpr std::string_view INFER_ARG_KEY_MEM_PATTERN{"mem_pattern"};
+// ORT_DISABLE_ALL/ORT_ENABLE_BASIC/ORT_ENABLE_EXTENDED/ORT_ENABLE_ALL
+constexpr std::string_view INFER_ARG_KEY_GRAPH_OPTIMIZATION_LEVEL{
+    "graph_optimization_level"};
+constexpr std::string_view INFER_ARG_KEY_DENORMAL_AS_ZERO{"denormal_as_zero"};
+// "0"时session使用独立的非arena分配器，不共享env的arena
+constexpr std::string_view INFER_ARG_KEY_CPU_ARENA{"cpu_arena"};
+// 非空时开启ORT的算子级性能分析，JSON文件写到"<前缀>_<时间>.json"，
+// 模型的EndProfiling结束记录并返回文件路径
+constexpr std::string_view INFER_ARG_KEY_PROFILE_PREFIX{"profile_prefix"};
+// kOff/kLatency/kThroughput，见InferAutoTune，只作用于CPU EP
+constexpr std::string_view INFER_ARG_KEY_AUTOTUNE{"autotune"};
+// 以下为context级参数："1"时所有session共享env的全局线程池，
+// session级的线程数和spinning参数不再生效
+constexpr std::string_view INFER_ARG_KEY_GLOBAL_THREAD_POOLS{
+    "global_thread_pools"};
+constexpr std::string_view INFER_ARG_KEY_GLOBAL_INTRA_OP_THREADS{
+    "global_intra_op_threads"};
+constexpr std::string_view INFER_ARG_KEY_GLOBAL_INTER_OP_THREADS{
+    "global_inter_op_threads"};
+constexpr std::string_view INFER_ARG_KEY_GLOBAL_ALLOW_SPINNING{
+    "global_allow_spinning"};
+// ORT的亲和性格式，如"1,2;3,4"表示两个worker线程分别绑定到逻辑核1,2和3,4
+constexpr std::string_view INFER_ARG_KEY_GLOBAL_INTRA_OP_AFFINITY{
+    "global_intra_op_affinity"};
+// 优化后模型(ORT格式)的缓存目录，为空时不缓存
+constexpr std::string_view INFER_ARG_KEY_MODEL_CACHE_DIR{"model_cache_dir"};
+// 自动调优结果的保存文件，按模型哈希和CPU型号索引，为空时只在进程内复用
+constexpr std::string_view INFER_ARG_KEY_AUTOTUNE_FILE{"autotune_file"};
+// "1"时向env注册大页内存池的分配器(见HugePage.h)，替代ORT的CPU arena，
+// 作用于cpu_arena为"1"的session的输入输出和中间张量，以及预处理缓冲区；
+// "0"时这些缓冲区使用普通堆内存
+constexpr std::string_view INFER_ARG_KEY_HUGE_PAGE_ALLOCATOR{
+    "huge_page_allocator"};
+// kTransparent/kExplicit
+constexpr std::string_view INFER_ARG_KEY_HUGE_PAGE_MODE{"huge_page_mode"};
+// 大页内存池空闲缓存的上限(MB)，超出的部分在释放时归还系统
+constexpr std::string_view INFER_ARG_KEY_HUGE_PAGE_MAX_CACHED_MB{
+    "huge_page_max_cached_mb"};
+
+/**
+ * session调优预设，显式设置的键优先于预设
+ */
+enum class InferSessionPreset : uint8_t {
+  // ORT默认线程数，关闭spinning
+  kDefault = 0,
+  // 单请求延迟优先：ORT默认线程数，开启spinning
+  kLatency,
+  // 多模型多请求并发：每个session只用少量线程，关闭spinning
+  kThroughput
+};
+
+/**
+ * 加载模型时以合成输入测量候选的线程数和执行模式，选出最优的配置，
+ * 覆盖intra_op_threads/inter_op_threads/execution_mode。
+ * 调优在创建session的线程上同步进行，耗时较长，宜在启动阶段加载这类模型；
+ * 候选全部失败时打印警告并使用未调优的配置
+ */
+enum class InferAutoTune : uint8_t {
+  kOff = 0,
+  // 单个调用方时每次推理的中位耗时最短
+  kLatency,
+  // 多个模型实例同时推理时单位时间完成的推理最多
+  kThroughput
+};
+
+/**
+ * 性能分析中一种算子类型的累计耗时
+ */
+struct InferProfileOp {
+  std::string op_type;
+  uint64_t calls{0};
+  uint64_t total_us{0};
+  double avg_us{0.0};
+};
+
+/**
+ * 按算子类型汇总ORT性能分析文件中的kernel耗时，按总耗时降序
+ * @param files EndProfiling返回的文件
+ */
+VISION_SIMPLE_API InferResult<std::vector<InferProfileOp>>
+SummarizeInferProfile(std::span<const std::string> files) noexcept;
+
 class VISION_SIMPLE_API InferContext {
 protected:
   InferFramework framework_;
@@ -79,6 +170,20 @@ struct YOLOFrameResult {
   std::vector<YOLOResult> results;
 };
 
+/**
+ * 单次Run的分阶段耗时(纳秒)
+ */
+struct YOLORunTiming {
+  uint64_t preprocess_ns{0};
+  uint64_t session_run_ns{0};
+  uint64_t output_convert_ns{0};
+  uint64_t decode_ns{0};
+  uint64_t nms_ns{0};
+};
+
+/**
+ * Run可以在多个线程上调用，同一实例的调用串行执行
+ */
 class VISION_SIMPLE_API InferYOLO {
 public:
   using CreateResult = InferResult<std::unique_ptr<InferYOLO>>;
@@ -91,26 +196,37 @@ public:
   InferYOLO& operator=(InferYOLO&&) = default;
   virtual YOLOVersion version() const noexcept = 0;
   virtual const std::vector<std::string>& class_names() const noexcept =0;
-  virtual RunResult Run(const cv::Mat& image,
-                        float confidence_threshold) noexcept = 0;
+  /**
+   * @param timing 不为空时填充分阶段耗时
+   */
+  virtual RunResult Run(const cv::Mat& image, float confidence_threshold,
+                        YOLORunTiming* timing = nullptr) noexcept = 0;
+  /**
+   * 结束性能分析，只对以INFER_ARG_KEY_PROFILE_PREFIX创建的模型有效
+   * @return 写出的分析文件，未开启时为空
+   */
+  virtual std::vector<std::string> EndProfiling() noexcept = 0;
+  /**
+   * @param session_args 该模型的session调优参数，见INFER_ARG_KEY_*
+   */
   static CreateResult Create(InferContext& context, std::span<uint8_t> data,
-                             YOLOVersion version,
-                             size_t device_id = 0) noexcept;
+                             YOLOVersion version, size_t device_id = 0,
+                             const InferArgs& session_args = {}) noexcept;
 
   template <typename T>
     requires std::is_arithmetic_v<T>
   static CreateResult Create(InferContext& context, std::span<T> data,
-                             YOLOVersion version,
-                             size_t device_id = 0) noexcept {
+                             YOLOVersion version, size_t device_id = 0,
+                             const InferArgs& session_args = {}) noexcept {
     return Create(context,
                   std::span(reinterpret_cast<uint8_t*>(data.data()),
                             data.size_bytes()),
-                  version, device_id);
+                  version, device_id, session_args);
   }
 
   static CreateResult Create(InferContext& context, const std::string& path,
-                             YOLOVersion version,
-                             size_t device_id = 0) noexcept;
+                             YOLOVersion version, size_t device_id = 0,
+                             const InferArgs& session_args = {}) noexcept;
 };
 
 //--------OCR--------
@@ -130,10 +246,70 @@ struct OCRFrameResult {
   std::vector<OCRResult> results;
 };
 
+enum class OCRDetLimitType : uint8_t {
+  // 最长边超过det_limit_side_len时缩小
+  kMax = 0,
+  // 最短边小于det_limit_side_len时放大
+  kMin
+};
+
+/**
+ * OCR推理选项
+ */
+struct OCROptions {
+  // rec单次推理的最大文本框数，1为逐框推理，rec模型的batch维为固定值时按1处理
+  uint32_t rec_batch_size{8};
+  // rec并行worker线程数，0为在调用线程串行执行
+  uint32_t rec_threads{0};
+  // rec输入的最大宽度，更宽的文本行切分为相互重叠的片段识别后拼接，0为不限制
+  uint32_t rec_max_width{960};
+  // rec结果缓存的最大条目数，按片段像素的哈希命中时跳过rec，0为不启用
+  uint32_t rec_cache_entries{0};
+  // det概率图二值化阈值
+  float det_threshold{0.3f};
+  // 文本框内平均概率低于该值时丢弃，0为不过滤
+  float det_box_threshold{0.6f};
+  // det输入边长限制，0为按原图尺寸推理
+  uint32_t det_limit_side_len{960};
+  OCRDetLimitType det_limit_type{OCRDetLimitType::kMax};
+  // RunBatch中det输入尺寸相同的图片单次det推理的最大数量，
+  // det模型的batch维为固定值时按1处理
+  uint32_t det_batch_size{4};
+  // det和rec session的调优参数，见INFER_ARG_KEY_*
+  InferArgs session_args;
+};
+
+/**
+ * 单次Run的分阶段耗时(纳秒)，rec阶段为所有文本框的累计值
+ */
+struct OCRRunTiming {
+  uint64_t det_preprocess_ns{0};
+  uint64_t det_run_ns{0};
+  uint64_t det_postprocess_ns{0};
+  uint64_t rec_preprocess_ns{0};
+  uint64_t rec_run_ns{0};
+  uint64_t rec_postprocess_ns{0};
+  uint32_t rec_count{0};
+};
+
+/**
+ * rec结果缓存的累计统计，hits/misses按文本片段计数
+ */
+struct OCRRecCacheStats {
+  uint64_t hits{0};
+  uint64_t misses{0};
+  uint64_t evictions{0};
+  uint64_t entries{0};
+};
+
+/**
+ * 推理接口可以在多个线程上调用，同一实例的调用串行执行
+ */
 class VISION_SIMPLE_API InferOCR {
 public:
   using CreateResult = InferResult<std::unique_ptr<InferOCR>>;
   using RunResult = InferResult<OCRFrameResult>;
+  using DetectResult = InferResult<std::vector<cv::Rect>>;
   InferOCR() = default;
   virtual ~InferOCR() = default;
   InferOCR(const InferOCR&) = delete;
@@ -141,14 +317,46 @@ public:
   InferOCR& operator=(const InferOCR&) = delete;
   InferOCR& operator=(InferOCR&&) = default;
   virtual OCRModelType model_type() const noexcept =0;
-  virtual RunResult Run(const cv::Mat& image,
-                        float confidence_threshold) noexcept = 0;
+  /**
+   * @param timing 不为空时填充分阶段耗时
+   */
+  virtual RunResult Run(const cv::Mat& image, float confidence_threshold,
+                        OCRRunTiming* timing = nullptr) noexcept = 0;
+  /**
+   * 只检测文本区域，不做识别
+   */
+  virtual DetectResult Detect(const cv::Mat& image,
+                              OCRRunTiming* timing = nullptr) noexcept = 0;
+  /**
+   * 只识别调用者给定的文本框，结果与boxes一一对应
+   * @param boxes 原图坐标系下的文本框，超出图片的部分会被裁掉
+   */
+  virtual RunResult Recognize(const cv::Mat& image,
+                              std::span<const cv::Rect> boxes,
+                              float confidence_threshold,
+                              OCRRunTiming* timing = nullptr) noexcept = 0;
+  /**
+   * 多图推理，下一张图的det与当前图的rec在不同线程上并行
+   * @param timing 不为空时填充所有图片的累计耗时
+   * @return 与images一一对应的结果
+   */
+  virtual std::vector<RunResult> RunBatch(
+      std::span<const cv::Mat> images, float confidence_threshold,
+      OCRRunTiming* timing = nullptr) noexcept = 0;
+  virtual OCRRecCacheStats rec_cache_stats() const noexcept = 0;
+  /**
+   * 结束det和rec的性能分析，只对session_args含INFER_ARG_KEY_PROFILE_PREFIX
+   * 的模型有效
+   * @return 写出的分析文件，未开启时为空
+   */
+  virtual std::vector<std::string> EndProfiling() noexcept = 0;
   static CreateResult Create(InferContext& context,
                              std::map<int, std::string> char_dict,
                              std::span<uint8_t> det_data,
                              std::span<uint8_t> rec_data,
                              OCRModelType model_type,
-                             size_t device_id = 0) noexcept;
+                             size_t device_id = 0,
+                             const OCROptions& options = {}) noexcept;
 
   template <typename T>
     requires std::is_arithmetic_v<T>
@@ -156,7 +364,8 @@ public:
                              std::map<int, std::string> char_dict,
                              std::span<T> det_data, std::span<T> rec_data,
                              OCRModelType model_type,
-                             size_t device_id = 0) noexcept {
+                             size_t device_id = 0,
+                             const OCROptions& options = {}) noexcept {
     return Create(context, std::move(char_dict),
                   std::span<uint8_t>{
                       reinterpret_cast<uint8_t*>(det_data.data()),
@@ -164,7 +373,7 @@ public:
                   std::span<uint8_t>{
                       reinterpret_cast<uint8_t*>(rec_data.data()),
                       rec_data.size_bytes()},
-                  model_type, device_id);
+                  model_type, device_id, options);
   }
 
   static CreateResult Create(InferContext& context,
@@ -172,6 +381,7 @@ public:
                              const std::string& det_path,
                              const std::string& rec_path,
                              OCRModelType model_type,
-                             size_t device_id = 0) noexcept;
+                             size_t device_id = 0,
+                             const OCROptions& options = {}) noexcept;
 };
 }
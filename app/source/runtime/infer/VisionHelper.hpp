@@ -1,12 +1,18 @@
 ﻿#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
 #include <span>
-#if defined(__x86_64__)
+#if defined(__x86_64__) || defined(__AVX2__)
 #include <immintrin.h>
 #endif
 #include <onnxruntime_cxx_api.h>
 
 #include <opencv2/opencv.hpp>
 
+#include "HugePage.h"
+
 namespace vision_simple {
 template <typename From, typename To>
   requires std::is_default_constructible_v<From> &&
@@ -172,6 +178,69 @@ class Cvt {
                   float* output) noexcept {
     return fp16tofp32(from, output);
   }
+
+  // uint8/int8->fp32，real = (q - zero_point) * scale
+  template <typename T>
+    requires std::is_same_v<T, uint8_t> || std::is_same_v<T, int8_t>
+  static void dequantize(std::span<const T> from, float scale,
+                         int32_t zero_point, float* output) noexcept {
+    for (size_t i = 0; i < from.size(); ++i)
+      output[i] =
+          static_cast<float>(static_cast<int32_t>(from[i]) - zero_point) *
+          scale;
+  }
+};
+
+/**
+ * 从HugePagePool分配的OpenCV分配器，用于随输入尺寸反复重建的中间图像
+ */
+class HugePageMatAllocator final : public cv::MatAllocator {
+ public:
+  static HugePageMatAllocator* Instance() noexcept {
+    // 不析构，静态对象中的Mat可能晚于它释放
+    static auto* allocator = new HugePageMatAllocator();
+    return allocator;
+  }
+
+  // 与cv::StdMatAllocator相同，只替换了内存来源
+  cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0,
+                         size_t* step, cv::AccessFlag,
+                         cv::UMatUsageFlags) const override {
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; --i) {
+      if (step) {
+        if (data0 && step[i] != CV_AUTOSTEP) {
+          CV_Assert(total <= step[i]);
+          total = step[i];
+        } else {
+          step[i] = total;
+        }
+      }
+      total *= sizes[i];
+    }
+    auto data = data0 ? static_cast<uchar*>(data0)
+                      : static_cast<uchar*>(
+                            HugePagePool::Instance().Allocate(total));
+    auto u = new cv::UMatData(this);
+    u->data = u->origdata = data;
+    u->size = total;
+    if (data0) u->flags |= cv::UMatData::USER_ALLOCATED;
+    return u;
+  }
+
+  bool allocate(cv::UMatData* u, cv::AccessFlag,
+                cv::UMatUsageFlags) const override {
+    return u != nullptr;
+  }
+
+  void deallocate(cv::UMatData* u) const override {
+    if (!u) return;
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED))
+      HugePagePool::Instance().Free(u->origdata);
+    delete u;
+  }
 };
 
 class VisionHelper {
@@ -179,7 +248,17 @@ class VisionHelper {
   std::vector<cv::Mat> channels_{3};
 
  public:
-  VisionHelper() = default;
+  VisionHelper() {
+    UseScratchAllocator(letterbox_resized_image_);
+    UseScratchAllocator(letterbox_dst_image_);
+    for (auto& channel : channels_) UseScratchAllocator(channel);
+  }
+
+  // 大页内存池开启时mat之后create从池中分配，需在mat为空时调用
+  static void UseScratchAllocator(cv::Mat& mat) noexcept {
+    if (HugePagePool::Instance().enabled())
+      mat.allocator = HugePageMatAllocator::Instance();
+  }
 
   cv::Mat& Letterbox(const cv::Mat& src, const cv::Size& target_size,
                      const cv::Scalar& color = cv::Scalar(0, 0, 0)) noexcept {
@@ -193,8 +272,8 @@ class VisionHelper {
     resize(src, letterbox_resized_image_, {new_width, new_height});
     if (letterbox_dst_image_.rows != target_size.height ||
         letterbox_dst_image_.cols != target_size.width) {
-      letterbox_dst_image_ =
-          cv::Mat::zeros(target_size.height, target_size.width, src.type());
+      letterbox_dst_image_.create(target_size.height, target_size.width,
+                                  src.type());
     }
     letterbox_dst_image_.setTo(color);
     int top = (target_size.height - new_height) / 2;
@@ -250,44 +329,94 @@ class VisionHelper {
     return result;
   }
 
-  double ComputeIOU(const cv::Rect& rect1, const cv::Rect& rect2) {
-    // 计算交集
-    cv::Rect intersection = rect1 & rect2;
-
-    // 计算并集
-    cv::Rect union_rect = rect1 | rect2;
-
-    // 交集面积
-    double intersectionArea = intersection.area();
-
-    // 并集面积
-    double unionArea = union_rect.area();
-
-    // 计算IOU
-    return intersectionArea / unionArea;
+  static double ComputeIOU(const cv::Rect& rect1,
+                           const cv::Rect& rect2) noexcept {
+    const double intersection_area = (rect1 & rect2).area();
+    const double union_area = static_cast<double>(rect1.area()) +
+                              rect2.area() - intersection_area;
+    return union_area > 0 ? intersection_area / union_area : 0.0;
   }
 
-  // 根据IOU阈值进行过滤
-  std::vector<cv::Rect> FilterByIOU(std::vector<cv::Rect>& boxes,
-                                    double iou_threshold) {
-    std::vector<cv::Rect> filteredBoxes;
+  // 交集占较小矩形的比例，小框被大框包含时为1
+  static double ComputeIOS(const cv::Rect& rect1,
+                           const cv::Rect& rect2) noexcept {
+    const double intersection_area = (rect1 & rect2).area();
+    const double min_area = std::min(rect1.area(), rect2.area());
+    return min_area > 0 ? intersection_area / min_area : 0.0;
+  }
 
-    for (size_t i = 0; i < boxes.size(); i++) {
+  enum class OverlapMetric : uint8_t { kIOU = 0, kIOS };
+
+  /**
+   * 按输入顺序贪心去重：与已保留的任一矩形重合度大于阈值的矩形被丢弃，
+   * 结果保持输入顺序。已保留的矩形按均匀网格索引，只与相邻格内的矩形比较
+   * @param overlap_threshold 重合度阈值
+   * @param metric 重合度的计算方式
+   */
+  static std::vector<cv::Rect> FilterByIOU(
+      const std::vector<cv::Rect>& boxes, double overlap_threshold,
+      OverlapMetric metric = OverlapMetric::kIOU) {
+    std::vector<cv::Rect> kept;
+    if (boxes.empty()) return kept;
+    cv::Rect bounds = boxes.front();
+    double total_width = 0, total_height = 0;
+    for (const auto& box : boxes) {
+      bounds |= box;
+      total_width += box.width;
+      total_height += box.height;
+    }
+    // 格子取平均框大小，格子总数不超过框数的4倍
+    const double count = static_cast<double>(boxes.size());
+    double cell_width = std::max(total_width / count, 1.0);
+    double cell_height = std::max(total_height / count, 1.0);
+    const double cell_scale = std::sqrt(
+        std::max(bounds.area() / (cell_width * cell_height) / (4.0 * count),
+                 1.0));
+    cell_width *= cell_scale;
+    cell_height *= cell_scale;
+    const int cols = static_cast<int>(bounds.width / cell_width) + 1;
+    const int rows = static_cast<int>(bounds.height / cell_height) + 1;
+    // 矩形覆盖的格子范围
+    const auto cell_range = [&](const cv::Rect& box) {
+      const auto cell = [&](const cv::Point& point) {
+        return cv::Point{static_cast<int>((point.x - bounds.x) / cell_width),
+                         static_cast<int>((point.y - bounds.y) / cell_height)};
+      };
+      return cv::Rect{cell(box.tl()), cell(box.br()) + cv::Point{1, 1}} &
+             cv::Rect{0, 0, cols, rows};
+    };
+    std::vector<std::vector<uint32_t>> cells(static_cast<size_t>(cols) * rows);
+    // 本轮已比较过的保留框，避免跨格的框重复比较
+    std::vector<size_t> visited;
+    kept.reserve(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i) {
+      const auto& box = boxes[i];
+      const auto range = cell_range(box);
       bool keep = true;
-      for (size_t j = 0; j < filteredBoxes.size(); j++) {
-        // 如果当前框和已过滤框的IOU大于阈值，丢弃当前框
-        if (ComputeIOU(boxes[i], filteredBoxes[j]) > iou_threshold) {
-          keep = false;
-          break;
+      for (int y = range.y; keep && y < range.br().y; ++y) {
+        for (int x = range.x; keep && x < range.br().x; ++x) {
+          for (auto k : cells[static_cast<size_t>(y) * cols + x]) {
+            if (visited[k] == i) continue;
+            visited[k] = i;
+            const double overlap = metric == OverlapMetric::kIOU
+                                       ? ComputeIOU(box, kept[k])
+                                       : ComputeIOS(box, kept[k]);
+            if (overlap > overlap_threshold) {
+              keep = false;
+              break;
+            }
+          }
         }
       }
-      if (keep) {
-        filteredBoxes.push_back(boxes[i]);
-      }
+      if (!keep) continue;
+      const auto index = static_cast<uint32_t>(kept.size());
+      kept.emplace_back(box);
+      visited.emplace_back(i);
+      for (int y = range.y; y < range.br().y; ++y)
+        for (int x = range.x; x < range.br().x; ++x)
+          cells[static_cast<size_t>(y) * cols + x].emplace_back(index);
     }
-
-    // 将过滤后的框替换回原始框列表
-    return filteredBoxes;
+    return kept;
   }
 
   static cv::Rect ScaleRect(const cv::Rect& rect, double scale_width,
@@ -308,4 +437,76 @@ class VisionHelper {
     return {new_x, new_y, new_width, new_height};
   }
 };
+
+/**
+ * 查找最大值及其下标，存在多个最大值时返回最小下标(与std::max_element一致)
+ * @return size为0时返回{lowest, 0}
+ */
+inline std::pair<float, size_t> ArgMax(const float* data,
+                                       size_t size) noexcept {
+  float max_value = std::numeric_limits<float>::lowest();
+  size_t max_index = 0;
+  size_t i = 0;
+#if defined(__AVX2__)
+  if (size >= 8) {
+    __m256 best = _mm256_loadu_ps(data);
+    __m256i best_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i index = best_index;
+    const __m256i step = _mm256_set1_epi32(8);
+    for (i = 8; i + 8 <= size; i += 8) {
+      index = _mm256_add_epi32(index, step);
+      const __m256 value = _mm256_loadu_ps(data + i);
+      const __m256 greater = _mm256_cmp_ps(value, best, _CMP_GT_OQ);
+      best = _mm256_blendv_ps(best, value, greater);
+      best_index = _mm256_blendv_epi8(best_index, index,
+                                      _mm256_castps_si256(greater));
+    }
+    alignas(32) float values[8];
+    alignas(32) int32_t indices[8];
+    _mm256_store_ps(values, best);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(indices), best_index);
+    max_value = values[0];
+    max_index = static_cast<size_t>(indices[0]);
+    for (int lane = 1; lane < 8; ++lane) {
+      const auto lane_index = static_cast<size_t>(indices[lane]);
+      if (values[lane] > max_value ||
+          (values[lane] == max_value && lane_index < max_index)) {
+        max_value = values[lane];
+        max_index = lane_index;
+      }
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    if (data[i] > max_value) {
+      max_value = data[i];
+      max_index = i;
+    }
+  }
+  return {max_value, max_index};
+}
+
+/**
+ * 分阶段计时，未启用时不读取时钟
+ */
+class StageClock {
+  bool enabled_;
+  std::chrono::steady_clock::time_point last_;
+
+ public:
+  explicit StageClock(bool enabled) noexcept
+      : enabled_(enabled),
+        last_(enabled ? std::chrono::steady_clock::now()
+                      : std::chrono::steady_clock::time_point{}) {}
+
+  // 将距上次Lap的纳秒数累加到target
+  void Lap(uint64_t& target) noexcept {
+    if (!enabled_) return;
+    const auto now = std::chrono::steady_clock::now();
+    target += static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_)
+            .count());
+    last_ = now;
+  }
+};
 }  // namespace vision_simple
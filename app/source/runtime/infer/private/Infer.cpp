@@ -56,7 +56,13 @@ InferContext::CreateResult InferContext::Create(const InferFramework framework,
     case InferFramework::kCUSTOM_FRAMEWORK:
       return UNSUPPORTED(framework, ep);
     case InferFramework::kONNXRUNTIME:
-      return std::make_unique<InferContextORT>(ep, std::move(args));
+      try {
+        return std::make_unique<InferContextORT>(ep, std::move(args));
+      } catch (std::exception& e) {
+        return std::unexpected{VisionSimpleError{
+            VisionSimpleErrorCode::kParameterError,
+            std::format("unable to create ONNXRuntime context:{}", e.what())}};
+      }
     case InferFramework::kTVM:
       return UNSUPPORTED(framework, ep);
     default:
@@ -67,10 +73,13 @@ InferContext::CreateResult InferContext::Create(const InferFramework framework,
 InferYOLO::CreateResult InferYOLO::Create(InferContext& context,
                                           const std::string& path,
                                           YOLOVersion version,
-                                          size_t device_id) noexcept {
-  auto data_result = ReadAll(path);
-  if (!data_result) return std::unexpected(std::move(data_result.error()));
-  return Create(context, data_result->span(), version, device_id);
+                                          size_t device_id,
+                                          const InferArgs& session_args) noexcept {
+  // 模型数据只在创建session期间使用，直接映射文件
+  auto file_result = MappedFile::Open(path);
+  if (!file_result) return std::unexpected(std::move(file_result.error()));
+  return Create(context, file_result->span(), version, device_id,
+                session_args);
 }
 
 InferOCR::CreateResult InferOCR::Create(InferContext& context,
@@ -78,20 +87,21 @@ InferOCR::CreateResult InferOCR::Create(InferContext& context,
                                         const std::string& det_path,
                                         const std::string& rec_path,
                                         OCRModelType model_type,
-                                        size_t device_id) noexcept {
+                                        size_t device_id,
+                                        const OCROptions& options) noexcept {
   auto char_dict_result = ReadAllLines(char_dict_path);
   if (!char_dict_result)
     return std::unexpected(std::move(char_dict_result.error()));
-  auto det_data_result = ReadAll(det_path);
+  auto det_data_result = MappedFile::Open(det_path);
   if (!det_data_result)
     return std::unexpected(std::move(det_data_result.error()));
-  auto rec_data_rect = ReadAll(rec_path);
+  auto rec_data_rect = MappedFile::Open(rec_path);
   if (!rec_data_rect) return std::unexpected(std::move(rec_data_rect.error()));
   std::map<int, std::string> char_dict;
   for (auto [idx, c] : std::views::enumerate(*char_dict_result))
     char_dict.emplace(idx, c);
   return Create(context, char_dict, det_data_result->span(),
-                rec_data_rect->span(), model_type, device_id);
+                rec_data_rect->span(), model_type, device_id, options);
 }
 
 // InferOCR::DetResult InferOCR::Det(const cv::Mat* images, size_t count)
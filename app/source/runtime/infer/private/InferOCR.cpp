@@ -1,57 +1,311 @@
 #include "InferOCR.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <codecvt>
+#include <cstring>
+#include <future>
+#include <limits>
 #include <magic_enum.hpp>
 #include <memory_resource>
+#include <mutex>
 #include <numeric>
 
+#include "Hash.h"
+#include "HugePage.h"
 #include "InferORT.h"
+#include "LRUCache.h"
+#include "ThreadPool.h"
 #include "VisionHelper.hpp"
 
 namespace {
 // std::pmr::monotonic_buffer_resource mr{114514};
+constexpr int REC_IMAGE_HEIGHT = 48;
+// 同一批内最宽与最窄文本框的宽度比上限，避免过多padding
+constexpr float REC_BUCKET_MAX_WIDTH_RATIO = 1.5f;
+// 长文本行切分时相邻片段重叠的输入宽度
+constexpr int REC_SEGMENT_OVERLAP = 2 * REC_IMAGE_HEIGHT;
+// 等价于原先连续三次6x6膨胀：每次偏移[-3,2]，合成后为[-9,6]
+constexpr int DET_DILATE_KERNEL_SIZE = 16;
+const cv::Point DET_DILATE_ANCHOR{9, 9};
+
+/**
+ * 概率图二值化，大于threshold的像素为255，否则为0
+ */
+void Binarize(const float* src, uint8_t* dst, size_t size,
+              float threshold) noexcept {
+  size_t i = 0;
+#if defined(__AVX2__)
+  const __m256 th = _mm256_set1_ps(threshold);
+  // packs在128位lane内交错，最后按dword重排回原始顺序
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  for (; i + 32 <= size; i += 32) {
+    const __m256i m0 = _mm256_castps_si256(
+        _mm256_cmp_ps(_mm256_loadu_ps(src + i), th, _CMP_GT_OQ));
+    const __m256i m1 = _mm256_castps_si256(
+        _mm256_cmp_ps(_mm256_loadu_ps(src + i + 8), th, _CMP_GT_OQ));
+    const __m256i m2 = _mm256_castps_si256(
+        _mm256_cmp_ps(_mm256_loadu_ps(src + i + 16), th, _CMP_GT_OQ));
+    const __m256i m3 = _mm256_castps_si256(
+        _mm256_cmp_ps(_mm256_loadu_ps(src + i + 24), th, _CMP_GT_OQ));
+    const __m256i packed = _mm256_packs_epi16(_mm256_packs_epi32(m0, m1),
+                                              _mm256_packs_epi32(m2, m3));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_permutevar8x32_epi32(packed, order));
+  }
+#endif
+  for (; i < size; ++i) dst[i] = src[i] > threshold ? 255 : 0;
+}
+
+struct RecCacheKey {
+  uint64_t hash;
+  int width, height;
+
+  bool operator==(const RecCacheKey& other) const noexcept = default;
+};
+
+struct RecCacheKeyHash {
+  size_t operator()(const RecCacheKey& key) const noexcept {
+    return static_cast<size_t>(key.hash);
+  }
+};
+
+/**
+ * 对box区域的像素做精确哈希，并混入影响解码结果的参数
+ * @param params 解码参数，如置信度阈值和片段保留范围
+ */
+RecCacheKey MakeRecCacheKey(const cv::Mat& image, const cv::Rect& box,
+                            std::initializer_list<float> params) noexcept {
+  uint64_t hash = 0;
+  const size_t row_bytes = static_cast<size_t>(box.width) * image.elemSize();
+  for (int y = box.y; y < box.y + box.height; ++y)
+    hash = vision_simple::Hash64(
+        std::span{image.ptr<uint8_t>(y, box.x), row_bytes}, hash);
+  for (float param : params) {
+    uint32_t bits;
+    std::memcpy(&bits, &param, sizeof(bits));
+    hash = vision_simple::HashCombine(hash, bits);
+  }
+  return RecCacheKey{hash, box.width, box.height};
+}
+
+struct ResizeTap {
+  int x0, x1;
+  float weight;
+};
+
+/**
+ * rec输入的像素编码：float归一化到[-1,1]；uint8/int8直接使用像素值，
+ * 对应scale=2/255、zero_point=128/0的量化
+ * @param value [0,255]的像素值
+ */
+template <typename T>
+T EncodeRecPixel(float value) noexcept {
+  if constexpr (std::is_same_v<T, float>)
+    return value * (2.f / 255.f) - 1.f;
+  else if constexpr (std::is_same_v<T, uint8_t>)
+    return static_cast<uint8_t>(value + 0.5f);
+  else
+    return static_cast<int8_t>(static_cast<int>(value + 0.5f) - 128);
+}
+
+/**
+ * 从BGR图像中双线性采样box区域，直接写出编码后的平面RGB
+ * 采样坐标与cv::resize(INTER_LINEAR)一致，每行[width,stride)补归一化后的0
+ * @param image CV_8UC3图像
+ * @param width 输出宽度
+ * @param height 输出高度
+ * @param stride 输出行跨度(批次张量宽度)
+ * @param dst 输出起始地址，大小为3*height*stride
+ * @param taps 复用的水平采样表
+ */
+template <typename T>
+void CropResizeNormalize(const cv::Mat& image, const cv::Rect& box, int width,
+                         int height, int stride, T* dst,
+                         std::vector<ResizeTap>& taps) noexcept {
+  const T zero = EncodeRecPixel<T>(127.5f);
+  const float scale_x = static_cast<float>(box.width) / width;
+  const float scale_y = static_cast<float>(box.height) / height;
+  taps.resize(width);
+  for (int x = 0; x < width; ++x) {
+    const float fx = std::max((x + 0.5f) * scale_x - 0.5f, 0.f);
+    const int x0 = std::min(static_cast<int>(fx), box.width - 1);
+    const int x1 = std::min(x0 + 1, box.width - 1);
+    taps[x] = {(box.x + x0) * 3, (box.x + x1) * 3, fx - static_cast<float>(x0)};
+  }
+  const size_t plane = static_cast<size_t>(height) * stride;
+  for (int y = 0; y < height; ++y) {
+    const float fy = std::max((y + 0.5f) * scale_y - 0.5f, 0.f);
+    const int y0 = std::min(static_cast<int>(fy), box.height - 1);
+    const int y1 = std::min(y0 + 1, box.height - 1);
+    const float wy = fy - static_cast<float>(y0);
+    const auto row0 = image.ptr<uint8_t>(box.y + y0);
+    const auto row1 = image.ptr<uint8_t>(box.y + y1);
+    T* r = dst + static_cast<size_t>(y) * stride;
+    T* g = r + plane;
+    T* b = g + plane;
+    for (int x = 0; x < width; ++x) {
+      const auto& tap = taps[x];
+      T bgr[3];
+      for (int c = 0; c < 3; ++c) {
+        const float top =
+            row0[tap.x0 + c] + (row0[tap.x1 + c] - row0[tap.x0 + c]) * tap.weight;
+        const float bottom =
+            row1[tap.x0 + c] + (row1[tap.x1 + c] - row1[tap.x0 + c]) * tap.weight;
+        bgr[c] = EncodeRecPixel<T>(top + (bottom - top) * wy);
+      }
+      r[x] = bgr[2];
+      g[x] = bgr[1];
+      b[x] = bgr[0];
+    }
+    const size_t pad = stride - width;
+    std::fill_n(r + width, pad, zero);
+    std::fill_n(g + width, pad, zero);
+    std::fill_n(b + width, pad, zero);
+  }
+}
 }
 
 vision_simple::InferOCR::CreateResult vision_simple::InferOCR::Create(
     InferContext& context, std::map<int, std::string> char_dict,
     std::span<uint8_t> det_data, std::span<uint8_t> rec_data,
-    OCRModelType model_type, size_t device_id) noexcept {
+    OCRModelType model_type, size_t device_id,
+    const OCROptions& options) noexcept {
   auto& ort_ctx = dynamic_cast<InferContextORT&>(context);
-  auto det = ort_ctx.CreateSession(det_data, device_id);
+  // ORT的分析文件名只精确到秒，det和rec使用不同的前缀以免互相覆盖
+  auto session_args_for = [&options](std::string_view suffix) {
+    auto args = options.session_args;
+    if (auto it = args.find(std::string{INFER_ARG_KEY_PROFILE_PREFIX});
+        it != args.end() && !it->second.empty())
+      it->second.append(suffix);
+    return args;
+  };
+  auto det =
+      ort_ctx.CreateSession(det_data, device_id, session_args_for("_det"));
   if (!det) return std::unexpected(std::move(det.error()));
-  auto rec = ort_ctx.CreateSession(rec_data, device_id);
+  auto rec =
+      ort_ctx.CreateSession(rec_data, device_id, session_args_for("_rec"));
   if (!rec) return std::unexpected(std::move(rec.error()));
+  // 输入为fp32或直接使用像素值的uint8/int8，输出另支持fp16
+  auto output_quant_of =
+      [](Ort::Session& session) -> InferResult<OrtQuantParams> {
+    const auto input_type =
+        session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetElementType();
+    const auto output_type = session.GetOutputTypeInfo(0)
+                                 .GetTensorTypeAndShapeInfo()
+                                 .GetElementType();
+    if (input_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT &&
+        !IsOrtQuantizedType(input_type))
+      return MK_VSERROR(VisionSimpleErrorCode::kModelError,
+                        std::format("unsupported input value type:{}",
+                                    magic_enum::enum_name(input_type)));
+    if (output_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT &&
+        output_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16 &&
+        !IsOrtQuantizedType(output_type))
+      return MK_VSERROR(VisionSimpleErrorCode::kModelError,
+                        std::format("unsupported output value type:{}",
+                                    magic_enum::enum_name(output_type)));
+    return ReadOutputQuantParams(session);
+  };
+  auto det_quant = output_quant_of(**det);
+  if (!det_quant) return std::unexpected(std::move(det_quant.error()));
+  auto rec_quant = output_quant_of(**rec);
+  if (!rec_quant) return std::unexpected(std::move(rec_quant.error()));
   return std::make_unique<InferOCROrtPaddleImpl>(
       ort_ctx, model_type, std::move(char_dict), std::move(*det),
-      std::move(*rec));
+      std::move(*rec), options, *det_quant, *rec_quant);
 }
 
 struct vision_simple::InferOCROrtPaddleImpl::Impl {
+  // rec的一组独立绑定和缓冲区，每个并行worker独占一个
+  struct RecSlot {
+    Ort::IoBinding io_binding;
+    Ort::Value input_tensor{nullptr};
+    // 按rec_input_type存放的张量数据
+    std::vector<uint8_t, HugePageAllocator<uint8_t>> input_buffer;
+    std::vector<ResizeTap> taps;
+    // 非fp32输出转换后的结果
+    std::vector<float> output_fp32;
+    OCRRunTiming timing;
+
+    explicit RecSlot(Ort::Session& session) : io_binding(session) {}
+  };
+
+  // 一次rec推理的文本片段，超长文本行会被切分为多个片段
+  struct RecSegment {
+    cv::Rect rect;
+    // 所属文本框下标
+    size_t box;
+    // 解码保留的片段范围(占片段宽度的比例)，去掉与相邻片段重叠的一半
+    float keep_begin, keep_end;
+  };
+
+  struct RecLine {
+    std::string text;
+    float score_sum{0.0f};
+    uint32_t score_count{0};
+  };
+
   VisionHelper vision_helper;
   OCRModelType model_type;
-  std::map<int, std::string> char_dict;
+  OCROptions options;
+  // 字典的UTF-8字符连续存放，第i个字符为
+  // char_arena[char_offsets[i], char_offsets[i+1])
+  std::string char_arena;
+  std::vector<uint32_t> char_offsets;
   std::unique_ptr<Ort::Session> det, rec;
   Ort::Allocator det_allocator, rec_allocator;
-  Ort::IoBinding det_io_binding, rec_io_binding;
-  Ort::Value det_input_tensor, rec_input_tensor;
+  Ort::IoBinding det_io_binding;
+  Ort::Value det_input_tensor;
+  // det输入张量引用det_input_buffer，形状不变时直接复用
+  std::array<int64_t, 4> det_input_shape{};
+  std::vector<uint8_t, HugePageAllocator<uint8_t>> det_input_buffer;
+  std::vector<float> det_output_fp32;
+  // fp32输入归一化，uint8/int8输入直接使用像素值
+  ONNXTensorElementDataType det_input_type, rec_input_type;
+  OrtQuantParams det_output_quant, rec_output_quant;
   std::string det_input_name, det_output_name, rec_input_name, rec_output_name;
   Ort::MemoryInfo det_memory_info, rec_memory_info;
-  cv::Mat chwrgb_image, preprocessed_image;
+  cv::Mat chwrgb_image;
+  cv::Mat det_kernel, det_binary, det_dilated;
+  std::vector<RecSlot> rec_slots;
+  std::unique_ptr<ThreadPool> rec_pool;
+  // 片段像素到识别结果的缓存，rec_cache_entries为0时不启用
+  mutable std::mutex rec_cache_mutex;
+  LRUCache<RecCacheKey, RecLine, RecCacheKeyHash> rec_cache;
+  uint64_t rec_cache_hits{0}, rec_cache_misses{0};
+  // 多图推理时执行下一张图的det
+  ThreadPool pipeline_pool{1};
+  // det的绑定和缓冲区、rec slot由一次调用独占，同一实例的调用串行执行
+  std::mutex run_mutex;
 
   explicit Impl(InferContextORT& ort_ctx, OCRModelType model_type,
                 std::map<int, std::string> char_dict,
                 std::unique_ptr<Ort::Session> det,
-                std::unique_ptr<Ort::Session> rec)
+                std::unique_ptr<Ort::Session> rec, const OCROptions& options,
+                const OrtQuantParams& det_output_quant,
+                const OrtQuantParams& rec_output_quant)
       : model_type(model_type),
-        char_dict(std::move(char_dict)),
+        options(options),
         det(std::move(det)),
         rec(std::move(rec)),
         det_allocator(*this->det, ort_ctx.env_memory_info()),
         rec_allocator(*this->rec, ort_ctx.env_memory_info()),
         det_io_binding(*this->det),
-        rec_io_binding(*this->rec),
         det_input_tensor{nullptr},
-        rec_input_tensor{nullptr},
+        det_input_type(this->det->GetInputTypeInfo(0)
+                           .GetTensorTypeAndShapeInfo()
+                           .GetElementType()),
+        rec_input_type(this->rec->GetInputTypeInfo(0)
+                           .GetTensorTypeAndShapeInfo()
+                           .GetElementType()),
+        det_output_quant(det_output_quant),
+        rec_output_quant(rec_output_quant),
         det_input_name(std::string(
             this->det->GetInputNameAllocated(0, det_allocator).get())),
         det_output_name(std::string(
@@ -65,9 +319,31 @@ struct vision_simple::InferOCROrtPaddleImpl::Impl {
             ort_ctx.env_memory_info().GetMemoryType())),
         rec_memory_info(Ort::MemoryInfo::CreateCpu(
             ort_ctx.env_memory_info().GetAllocatorType(),
-            ort_ctx.env_memory_info().GetMemoryType())) {
+            ort_ctx.env_memory_info().GetMemoryType())),
+        rec_cache(options.rec_cache_entries,
+                  std::numeric_limits<size_t>::max()) {
+    this->options.rec_batch_size = ClampBatchSize(
+        *this->rec, std::max<uint32_t>(this->options.rec_batch_size, 1));
+    this->options.det_batch_size = ClampBatchSize(
+        *this->det, std::max<uint32_t>(this->options.det_batch_size, 1));
+    if (this->options.rec_max_width > 0)
+      this->options.rec_max_width = std::max<uint32_t>(
+          PadLength<uint32_t>(this->options.rec_max_width, REC_IMAGE_HEIGHT),
+          2 * REC_SEGMENT_OVERLAP);
+    BuildCharTable(char_dict);
+    for (auto mat : {&chwrgb_image, &det_binary, &det_dilated})
+      VisionHelper::UseScratchAllocator(*mat);
+    det_kernel = cv::getStructuringElement(
+        cv::MORPH_RECT, cv::Size(DET_DILATE_KERNEL_SIZE, DET_DILATE_KERNEL_SIZE));
     det_io_binding.BindOutput(det_output_name.c_str(), det_memory_info);
-    rec_io_binding.BindOutput(rec_output_name.c_str(), rec_memory_info);
+    // 调用线程使用slot 0，线程池worker使用其余slot
+    rec_slots.reserve(this->options.rec_threads + 1);
+    for (uint32_t i = 0; i <= this->options.rec_threads; ++i) {
+      auto& slot = rec_slots.emplace_back(*this->rec);
+      slot.io_binding.BindOutput(rec_output_name.c_str(), rec_memory_info);
+    }
+    if (this->options.rec_threads > 0)
+      rec_pool = std::make_unique<ThreadPool>(this->options.rec_threads);
   }
 
   template <typename T>
@@ -78,78 +354,108 @@ struct vision_simple::InferOCROrtPaddleImpl::Impl {
     return length + pad_length;
   }
 
+  /**
+   * 输入dim 0为固定值的模型只能逐张推理，动态时保持batch_size
+   */
+  static uint32_t ClampBatchSize(Ort::Session& session, uint32_t batch_size) {
+    const auto shape =
+        session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    return shape.empty() || shape[0] < 0 ? batch_size : 1;
+  }
+
   static size_t GetTensorSize(const Ort::Value& value) noexcept {
     auto shapes = value.GetTensorTypeAndShapeInfo().GetShape();
     return std::accumulate(shapes.begin(), shapes.end(), 1llu,
                            std::multiplies());
   }
 
-  cv::Mat& DetPreProcess(const cv::Mat& image) noexcept {
-    const auto target_size =
-        cv::Size{PadLength(image.cols), PadLength(image.rows)};
+  // 按det_limit_side_len/det_limit_type计算det输入尺寸，对齐到32
+  cv::Size DetInputSize(const cv::Size& image_size) const noexcept {
+    const auto limit = static_cast<float>(options.det_limit_side_len);
+    float ratio = 1.f;
+    if (options.det_limit_side_len > 0) {
+      if (options.det_limit_type == OCRDetLimitType::kMax) {
+        const auto max_side = std::max(image_size.width, image_size.height);
+        if (max_side > limit) ratio = limit / static_cast<float>(max_side);
+      } else {
+        const auto min_side = std::min(image_size.width, image_size.height);
+        if (min_side < limit) ratio = limit / static_cast<float>(min_side);
+      }
+    }
+    return cv::Size{
+        PadLength(std::max(static_cast<int>(image_size.width * ratio), 1)),
+        PadLength(std::max(static_cast<int>(image_size.height * ratio), 1))};
+  }
+
+  /**
+   * @param target_size det输入尺寸
+   * @param dst det输入张量中该图片的起始地址
+   */
+  void DetPreProcess(const cv::Mat& image, const cv::Size& target_size,
+                     void* dst) noexcept {
+    // det在缩放后的图片上运行，rec仍从原图裁剪
     auto& padded_img = vision_helper.Letterbox(image, target_size);
+    if (det_input_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8) {
+      // 平面RGB即为输入，不做归一化
+      cv::Mat output{target_size, CV_8UC3, dst};
+      vision_helper.HWC2CHW_BGR2RGB<uint8_t>(padded_img, output);
+      return;
+    }
     if (chwrgb_image.rows != target_size.height ||
         chwrgb_image.cols != target_size.width)
-      chwrgb_image = cv::Mat::zeros(target_size, CV_8UC3);
+      chwrgb_image.create(target_size, CV_8UC3);
     vision_helper.HWC2CHW_BGR2RGB<uint8_t>(padded_img, chwrgb_image);
-    if (preprocessed_image.rows != target_size.height ||
-        preprocessed_image.cols != target_size.width)
-      preprocessed_image = cv::Mat::zeros(target_size, CV_32FC3);
-    chwrgb_image.convertTo(preprocessed_image, CV_32F, 1.f / 255.f);
-    return preprocessed_image;
+    // 直接写入张量，不经过中间的float图片
+    if (det_input_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8) {
+      // 对应scale=1/255、zero_point=-128的量化，即像素值减128
+      cv::Mat output{target_size, CV_8SC3, dst};
+      chwrgb_image.convertTo(output, CV_8S, 1.0, -128.0);
+    } else {
+      cv::Mat output{target_size, CV_32FC3, dst};
+      chwrgb_image.convertTo(output, CV_32F, 1.f / 255.f);
+    }
   }
 
   /**
-   *
-   * @param output_tensor session.Run()后通过IOBinding获得的张量
+   * DB后处理：二值化概率图，膨胀后查找轮廓，按框内平均概率过滤
+   * @param output_ptr 该图片的概率图
+   * @param output_size 概率图尺寸
    * @param input_image_size 输入张量图片的尺寸
    * @param original_image_size 原始图片尺寸
    * @param iou_threshold 矩形重合区域IOU阈值，大于该阈值的将会被去重
-   * @param contours_min_area 轮廓查找最小区域阈值
    * @param rect_min_area 矩形最小区域阈值
-   * @param kernel_size 膨胀操作的kernel_size
    * @return 找到的所有矩形
    */
-  std::vector<cv::Rect> DetPostProcess(const Ort::Value& output_tensor,
+  std::vector<cv::Rect> DetPostProcess(const float* output_ptr,
+                                       const cv::Size output_size,
                                        const cv::Size input_image_size,
                                        const cv::Size original_image_size,
                                        double iou_threshold = 0.3f,
-                                       double contours_min_area = 12. * 12.,
-                                       double rect_min_area = 8 * 8,
-                                       int kernel_size = 6) noexcept {
-    auto output_shape = output_tensor.GetTensorTypeAndShapeInfo().GetShape();
-    auto output_ptr = output_tensor.GetConst().GetTensorData<float>();
-    auto img = cv::Mat{static_cast<int>(output_shape[2]),
-                       static_cast<int>(output_shape[3]), CV_32FC1,
-                       (void*)(output_ptr)};
-    cv::Mat gray{img.rows, img.cols, CV_8UC1};
-    img.convertTo(gray, CV_8UC1);
-    cv::Mat dilated;
-    cv::Mat kernel = cv::getStructuringElement(
-        cv::MORPH_RECT, cv::Size(kernel_size, kernel_size));
-    cv::dilate(gray, dilated, kernel);
-    for (auto i = 0; i < 2; i++) {
-      cv::dilate(dilated, dilated, kernel);
-    }
-    std::vector<std::vector<cv::Point>> contours, filtered_contours;
+                                       double rect_min_area = 8 * 8) noexcept {
+    const auto prob = cv::Mat{output_size, CV_32FC1, (void*)(output_ptr)};
+    det_binary.create(prob.rows, prob.cols, CV_8UC1);
+    Binarize(output_ptr, det_binary.ptr<uint8_t>(), prob.total(),
+             options.det_threshold);
+    cv::dilate(det_binary, det_dilated, det_kernel, DET_DILATE_ANCHOR);
+    std::vector<std::vector<cv::Point>> contours;
 #if (CV_MAJOR_VERSION >= 4) && (CV_MINOR_VERSION >= 10)
-    cv::findContoursLinkRuns(dilated, contours);
+    cv::findContoursLinkRuns(det_dilated, contours);
 #else
-    std::vector<std::vector<cv::Point>> hierarchy;
-    cv::findContours(gray, contours, hierarchy, cv::RETR_TREE,
+    cv::findContours(det_dilated, contours, cv::RETR_LIST,
                      cv::CHAIN_APPROX_SIMPLE);
 #endif
-    for (const auto& contour : contours) {
-      if (contourArea(contour) > contours_min_area) {
-        filtered_contours.push_back(contour);  // 添加满足条件的轮廓
-      }
-    }
     std::vector<cv::Rect> rects;
+    rects.reserve(contours.size());
     for (const auto& contour : contours) {
       // 使用 boundingRect 拟合矩形
-      if (auto rect{boundingRect(contour)}; rect.area() > rect_min_area) {
-        rects.emplace_back(rect);
-      }
+      auto rect{boundingRect(contour)};
+      if (rect.area() <= rect_min_area) continue;
+      // 框内文字像素的平均概率，过滤噪声产生的低分框
+      if (options.det_box_threshold > 0.f &&
+          cv::mean(prob(rect), det_binary(rect))[0] <
+              options.det_box_threshold)
+        continue;
+      rects.emplace_back(rect);
     }
     auto filtered_boxes = vision_helper.FilterByIOU(rects, iou_threshold);
     // 重设到原始图片大小
@@ -160,153 +466,481 @@ struct vision_simple::InferOCROrtPaddleImpl::Impl {
     return filtered_boxes;
   }
 
-  Ort::Value RecPreProcess(const cv::Mat& image, const cv::Rect& box,
-                           int fixed_height = 48) {
+  // 文本框缩放到固定高度后的输入宽度
+  static int RecInputWidth(const cv::Rect& box,
+                           int fixed_height = REC_IMAGE_HEIGHT) noexcept {
     auto scale = static_cast<float>(fixed_height) / box.height;
-    auto width = PadLength(static_cast<int>(scale * box.width), fixed_height);
-    cv::Size output_size{width, fixed_height};
-    const auto output_image_size_bytes =
-        static_cast<size_t>(output_size.width) * output_size.height * 3 *
-        sizeof(float);
-    int64_t tensor_shape[4] = {1, 3, output_size.height, output_size.width};
-    auto tensor =
-        Ort::Value::CreateTensor<float>(rec_allocator, tensor_shape, 4);
-    auto tensor_base_ptr = tensor.GetTensorMutableData<float>();
-    auto box_image = image(box).clone();
-    resize(box_image, box_image, output_size);
-    cv::Mat resized_image = cv::Mat::zeros(output_size, CV_8UC3);
-    box_image.copyTo(
-        resized_image(cv::Rect(0, 0, box_image.cols, box_image.rows)));
-    VisionHelper vision_helper_tmp;
-    vision_helper_tmp.HWC2CHW_BGR2RGB<uint8_t>(resized_image, resized_image);
-    cv::Mat output_image{output_size, CV_32FC3};
-    resized_image.convertTo(output_image, CV_32F, 1.f / 255.f, -0.5f);
-    output_image /= 0.5f;
-    std::memcpy(tensor_base_ptr, output_image.ptr<float>(),
-                output_image_size_bytes);
-    return tensor;
+    return std::max(
+        PadLength(static_cast<int>(scale * box.width), fixed_height),
+        fixed_height);
   }
 
-  static auto FindMaxValueIndex(const std::span<const float> vec)
-      -> std::pair<float, size_t> {
-    // 使用std::max_element找到最大值的迭代器
-    auto max_it = std::ranges::max_element(vec);
-    // 如果vector为空，返回一个无效的值
-    if (max_it == vec.cend()) {
-      return {std::numeric_limits<float>::lowest(), static_cast<size_t>(-1)};
+  /**
+   * 输入宽度超过rec_max_width的文本框沿水平方向切分为相互重叠的片段，
+   * 每个片段的输入宽度不超过rec_max_width
+   * @param box_index 文本框下标
+   */
+  void SplitRecBox(const cv::Rect& box, size_t box_index,
+                   std::vector<RecSegment>& segments) const {
+    const int max_width = static_cast<int>(options.rec_max_width);
+    if (max_width == 0 || RecInputWidth(box) <= max_width) {
+      segments.emplace_back(RecSegment{box, box_index, 0.0f, 1.0f});
+      return;
     }
-    // 获取最大值及其索引
-    float max_value = *max_it;
-    size_t index = std::distance(vec.begin(), max_it);
+    // 换算到原图坐标
+    const float scale = static_cast<float>(REC_IMAGE_HEIGHT) / box.height;
+    const int segment_width =
+        std::max(static_cast<int>(max_width / scale), 1);
+    const int overlap = std::min(static_cast<int>(REC_SEGMENT_OVERLAP / scale),
+                                 segment_width / 2);
+    for (int x = 0;; x += segment_width - overlap) {
+      const int width = std::min(segment_width, box.width - x);
+      const bool last = x + width >= box.width;
+      const float half_overlap = 0.5f * overlap / width;
+      segments.emplace_back(RecSegment{
+          cv::Rect{box.x + x, box.y, width, box.height}, box_index,
+          x == 0 ? 0.0f : half_overlap, last ? 1.0f : 1.0f - half_overlap});
+      if (last) break;
+    }
+  }
 
-    return {max_value, index};
+  /**
+   * 将文本框写入批次张量的一个slot，右侧padding为0
+   * @param width 文本框自身的输入宽度
+   * @param batch_width 批次张量的宽度
+   * @param dst slot起始地址，3*fixed_height*batch_width个rec_input_type元素
+   */
+  void RecPreProcess(const cv::Mat& image, const cv::Rect& box, int width,
+                     int batch_width, void* dst, std::vector<ResizeTap>& taps,
+                     int fixed_height = REC_IMAGE_HEIGHT) const noexcept {
+    switch (rec_input_type) {
+      case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+        CropResizeNormalize(image, box, width, fixed_height, batch_width,
+                            static_cast<uint8_t*>(dst), taps);
+        break;
+      case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+        CropResizeNormalize(image, box, width, fixed_height, batch_width,
+                            static_cast<int8_t*>(dst), taps);
+        break;
+      default:
+        CropResizeNormalize(image, box, width, fixed_height, batch_width,
+                            static_cast<float*>(dst), taps);
+    }
   }
 
   /**
-   *
-   * @param output 张量输出
-   * @param output_shape 张量shape
-   * @param confidence_threshold 每个字符的置信度阈值
-   * @return
+   * 将字典展开为连续的字符表，缺失的下标对应空字符，
+   * 末尾追加PP-OCR的空格类别
    */
-  std::vector<std::pair<std::string, float>> RecPostProcess(
-      const std::span<const float> output,
-      const std::vector<int64_t>& output_shape,
-      float confidence_threshold = 0.5f) {
-    const auto stride = output_shape[1] * output_shape[2];
-    auto output_base_ptr = output.data();
-    std::vector<std::pair<std::string, float>> results;
-    auto num_features = output_shape[2];
-    for (auto i{0}; i < output_shape[0]; ++i) {
-      auto output_ptr = output_base_ptr + i * stride;
-      std::vector<std::pair<int, double>> idx_scores;
-      idx_scores.reserve(output_shape[1]);
-      for (auto j{0}; j < output_shape[1]; ++j) {
-        auto [max_score, max_idx] = FindMaxValueIndex(
-            std::span(output_ptr + j * num_features, num_features));
-        idx_scores.emplace_back(max_idx, max_score);
+  void BuildCharTable(const std::map<int, std::string>& char_dict) {
+    const int count = char_dict.empty() ? 0 : char_dict.rbegin()->first + 1;
+    size_t arena_size = 1;
+    for (const auto& [_, c] : char_dict) arena_size += c.size();
+    char_arena.reserve(arena_size);
+    char_offsets.reserve(count + 2);
+    char_offsets.emplace_back(0);
+    auto it = char_dict.begin();
+    for (int i = 0; i < count; ++i) {
+      if (it != char_dict.end() && it->first == i) {
+        char_arena.append(it->second);
+        ++it;
       }
-      std::stringstream ss;
-      std::vector<float> scores;
-      scores.reserve(idx_scores.size());
-      for (auto [idx, score] : idx_scores) {
-        if (idx == 0) continue;
-        if (score <= confidence_threshold) continue;
-        auto& c = char_dict[idx - 1];
-        ss << c;
-        scores.emplace_back(score);
-      }
-      auto confidence = !scores.empty() ? std::accumulate(scores.cbegin(),
-                                                          scores.cend(), 0.0f) /
-                                              static_cast<float>(scores.size())
-                                        : 0.0f;
-      results.emplace_back(ss.str(), confidence);
+      char_offsets.emplace_back(static_cast<uint32_t>(char_arena.size()));
     }
-    return results;
+    char_arena.push_back(' ');
+    char_offsets.emplace_back(static_cast<uint32_t>(char_arena.size()));
+  }
+
+  /**
+   * CTC贪心解码：逐步取argmax，合并相邻重复并去掉blank
+   * @param output 单个文本片段的张量输出，[steps, num_features]
+   * @param begin_step 解码的起始时间步
+   * @param end_step 解码的结束时间步(不含)
+   * @param num_features 类别数(含blank)
+   * @param confidence_threshold 每个字符的置信度阈值
+   * @param line 输出文本及保留字符的置信度之和、字符数
+   */
+  void RecPostProcess(const float* output, int64_t begin_step,
+                      int64_t end_step, int64_t num_features,
+                      float confidence_threshold,
+                      RecLine& line) const noexcept {
+    auto& text = line.text;
+    text.clear();
+    const size_t char_count = char_offsets.size() - 1;
+    float score_sum = 0.0f;
+    uint32_t score_count = 0;
+    size_t last_idx = 0;
+    for (int64_t j = begin_step; j < end_step; ++j) {
+      const auto [score, idx] =
+          ArgMax(output + j * num_features, static_cast<size_t>(num_features));
+      const bool repeated = idx == last_idx;
+      last_idx = idx;
+      if (idx == 0 || repeated || score <= confidence_threshold) continue;
+      if (idx - 1 >= char_count) continue;
+      text.append(char_arena, char_offsets[idx - 1],
+                  char_offsets[idx] - char_offsets[idx - 1]);
+      score_sum += score;
+      ++score_count;
+    }
+    line.score_sum = score_sum;
+    line.score_count = score_count;
+  }
+
+  /**
+   * 按宽度分桶：排序后相邻且宽度接近的片段组成一批
+   * @param order 需要推理的片段下标
+   * @return 每批片段的下标
+   */
+  std::vector<std::vector<size_t>> RecBuckets(
+      const std::vector<int>& widths, std::vector<size_t> order) const {
+    std::ranges::stable_sort(
+        order, [&widths](size_t a, size_t b) { return widths[a] < widths[b]; });
+    std::vector<std::vector<size_t>> buckets;
+    for (auto idx : order) {
+      if (buckets.empty() ||
+          buckets.back().size() >= options.rec_batch_size ||
+          widths[idx] > widths[buckets.back().front()] *
+                            REC_BUCKET_MAX_WIDTH_RATIO)
+        buckets.emplace_back();
+      buckets.back().emplace_back(idx);
+    }
+    return buckets;
   }
 
-  RunResult Run(const cv::Mat& image, float confidence_threshold) noexcept {
-    auto& input_image = DetPreProcess(image);
-    const cv::Size input_image_size{input_image.cols, input_image.rows},
-        original_image_size{image.cols, image.rows};
-    int64_t input_image_shape[4] = {1, 3, input_image.rows, input_image.cols};
-    auto input_size_bytes =
-        static_cast<unsigned long long>(input_image.channels()) *
-        input_image.rows * input_image.cols * sizeof(float);
-    det_input_tensor = Ort::Value::CreateTensor(
-        det_allocator, input_image_shape,
-        sizeof(input_image_shape) / sizeof(decltype(input_image_shape[0])),
-        ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
-    std::memcpy(det_input_tensor.GetTensorMutableData<float>(),
-                input_image.ptr<float>(), input_size_bytes);
+  /**
+   * 推理一批文本片段，结果按下标写入lines
+   * @param bucket 该批片段在segments中的下标
+   * @param slot 当前worker独占的rec slot
+   */
+  void RecBatch(const cv::Mat& image, const std::vector<RecSegment>& segments,
+                const std::vector<int>& widths,
+                const std::vector<size_t>& bucket, float confidence_threshold,
+                RecSlot& slot, bool timed, std::vector<RecLine>& lines) {
+    StageClock clock{timed};
+    auto& stage = slot.timing;
+    const int batch_width = widths[bucket.back()];
+    int64_t tensor_shape[4] = {static_cast<int64_t>(bucket.size()), 3,
+                               REC_IMAGE_HEIGHT, batch_width};
+    const size_t slot_size = static_cast<size_t>(3) * REC_IMAGE_HEIGHT *
+                             batch_width * OrtElementSize(rec_input_type);
+    // 张量直接引用复用的缓冲区，不再逐批分配
+    if (slot.input_buffer.size() < slot_size * bucket.size())
+      slot.input_buffer.resize(slot_size * bucket.size());
+    auto tensor_base_ptr = slot.input_buffer.data();
+    slot.input_tensor = Ort::Value::CreateTensor(
+        rec_memory_info, tensor_base_ptr, slot_size * bucket.size(),
+        tensor_shape, 4, rec_input_type);
+    for (size_t b = 0; b < bucket.size(); ++b)
+      RecPreProcess(image, segments[bucket[b]].rect, widths[bucket[b]],
+                    batch_width,
+                    tensor_base_ptr + b * slot_size, slot.taps);
+    clock.Lap(stage.rec_preprocess_ns);
+    slot.io_binding.BindInput(rec_input_name.c_str(), slot.input_tensor);
+    slot.io_binding.BindOutput(rec_output_name.c_str(), rec_memory_info);
+    // predict string
+    Ort::RunOptions rec_run_options{};
+    rec->Run(rec_run_options, slot.io_binding);
+    clock.Lap(stage.rec_run_ns);
+    ++stage.rec_count;
+    const auto& rec_outputs = slot.io_binding.GetOutputValues();
+    auto& rec_output_tensor = rec_outputs[0];
+    auto rec_output_shape =
+        rec_output_tensor.GetTensorTypeAndShapeInfo().GetShape();
+    const auto steps = rec_output_shape[1];
+    const auto num_features = rec_output_shape[2];
+    const auto output_base_ptr =
+        OrtTensorAsFloat(rec_output_tensor, rec_output_quant, slot.output_fp32);
+    for (size_t b = 0; b < bucket.size(); ++b) {
+      const auto valid_steps = std::min<int64_t>(
+          steps, (steps * widths[bucket[b]] + batch_width - 1) / batch_width);
+      const auto& segment = segments[bucket[b]];
+      RecPostProcess(
+          output_base_ptr + static_cast<int64_t>(b) * steps * num_features,
+          std::llround(segment.keep_begin * valid_steps),
+          std::llround(segment.keep_end * valid_steps), num_features,
+          confidence_threshold, lines[bucket[b]]);
+    }
+    clock.Lap(stage.rec_postprocess_ns);
+  }
+
+  static VSResult<void> CheckImage(const cv::Mat& image) noexcept {
+    if (image.empty() || image.type() != CV_8UC3)
+      return MK_VSERROR(VisionSimpleErrorCode::kParameterError,
+                        "image must be a non-empty BGR image");
+    return {};
+  }
+
+  /**
+   * det阶段，只使用det相关的成员，可与RecognizeBoxes在不同线程并行
+   * @param images 一次det推理的图片，det输入尺寸必须都为input_size
+   * @param stage 累加det阶段耗时
+   * @return 与images一一对应的文本框
+   */
+  std::vector<std::vector<cv::Rect>> DetectBoxes(
+      const std::vector<const cv::Mat*>& images, const cv::Size& input_size,
+      OCRRunTiming& stage, bool timed) {
+    StageClock clock{timed};
+    const std::array<int64_t, 4> shape{static_cast<int64_t>(images.size()), 3,
+                                       input_size.height, input_size.width};
+    const size_t image_size = static_cast<size_t>(3) * input_size.height *
+                              input_size.width * OrtElementSize(det_input_type);
+    if (shape != det_input_shape) {
+      det_input_buffer.resize(image_size * images.size());
+      det_input_tensor = Ort::Value::CreateTensor(
+          det_memory_info, det_input_buffer.data(), det_input_buffer.size(),
+          shape.data(), shape.size(), det_input_type);
+      det_input_shape = shape;
+    }
+    for (size_t b = 0; b < images.size(); ++b)
+      DetPreProcess(*images[b], input_size,
+                    det_input_buffer.data() + b * image_size);
     det_io_binding.BindInput(det_input_name.c_str(), det_input_tensor);
     det_io_binding.BindOutput(det_output_name.c_str(), det_memory_info);
+    clock.Lap(stage.det_preprocess_ns);
     Ort::RunOptions run_options;
     det->Run(run_options, det_io_binding);
+    clock.Lap(stage.det_run_ns);
     const auto& ovalues = det_io_binding.GetOutputValues();
     auto& output_tensor = ovalues[0];
-    auto boxes =
-        DetPostProcess(output_tensor, input_image_size, original_image_size);
-    OCRFrameResult frame_result;
-    // Q:为什么不批处理呢？
-    // A:因为效果不好
-    std::vector<Ort::Value> rec_input_tensors;
-    for (int64_t i = 0; i < boxes.size(); ++i) {
-      auto tensor = RecPreProcess(image, boxes[i]);
-      rec_input_tensors.emplace_back(std::move(tensor));
+    const auto output_shape =
+        output_tensor.GetTensorTypeAndShapeInfo().GetShape();
+    const cv::Size output_size{static_cast<int>(output_shape[3]),
+                               static_cast<int>(output_shape[2])};
+    const auto output_ptr =
+        OrtTensorAsFloat(output_tensor, det_output_quant, det_output_fp32);
+    std::vector<std::vector<cv::Rect>> boxes;
+    boxes.reserve(images.size());
+    for (size_t b = 0; b < images.size(); ++b)
+      boxes.emplace_back(DetPostProcess(
+          output_ptr + b * output_size.area(), output_size, input_size,
+          images[b]->size()));
+    clock.Lap(stage.det_postprocess_ns);
+    return boxes;
+  }
+
+  std::vector<cv::Rect> DetectBoxes(const cv::Mat& image, OCRRunTiming& stage,
+                                    bool timed) {
+    return std::move(
+        DetectBoxes({&image}, DetInputSize(image.size()), stage, timed)[0]);
+  }
+
+  /**
+   * rec阶段，只使用rec相关的成员，结果顺序与boxes一致
+   * @param boxes 已裁剪到图片范围内的文本框，空框输出空文本
+   * @param stage 累加rec阶段耗时
+   */
+  OCRFrameResult RecognizeBoxes(const cv::Mat& image,
+                                const std::vector<cv::Rect>& boxes,
+                                float confidence_threshold,
+                                OCRRunTiming& stage, bool timed) {
+    // 同一批内每个片段按自身宽度缩放，仅在右侧补0，
+    // 解码时只取各自的有效时间步，结果与逐框推理一致
+    std::vector<RecSegment> segments;
+    segments.reserve(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i)
+      if (!boxes[i].empty()) SplitRecBox(boxes[i], i, segments);
+    std::vector<RecLine> lines(segments.size());
+    std::vector<RecCacheKey> keys;
+    std::vector<size_t> pending;
+    pending.reserve(segments.size());
+    if (options.rec_cache_entries > 0) {
+      // 命中缓存的片段直接复用上次的结果，只推理变化的片段
+      keys.reserve(segments.size());
+      for (const auto& segment : segments)
+        keys.emplace_back(MakeRecCacheKey(
+            image, segment.rect,
+            {confidence_threshold, segment.keep_begin, segment.keep_end}));
+      std::lock_guard lock{rec_cache_mutex};
+      for (size_t i = 0; i < segments.size(); ++i) {
+        if (const auto* line = rec_cache.Get(keys[i]))
+          lines[i] = *line;
+        else
+          pending.emplace_back(i);
+      }
+      rec_cache_hits += segments.size() - pending.size();
+      rec_cache_misses += pending.size();
+    } else {
+      pending.resize(segments.size());
+      std::iota(pending.begin(), pending.end(), 0);
+    }
+    std::vector<int> widths(segments.size());
+    for (auto i : pending) widths[i] = RecInputWidth(segments[i].rect);
+    const auto buckets = RecBuckets(widths, pending);
+    for (auto& slot : rec_slots) slot.timing = OCRRunTiming{};
+    auto run_bucket = [&](size_t bucket_index, size_t worker) {
+      RecBatch(image, segments, widths, buckets[bucket_index],
+               confidence_threshold, rec_slots[worker], timed, lines);
+    };
+    if (rec_pool) {
+      rec_pool->ParallelFor(buckets.size(), run_bucket);
+    } else {
+      for (size_t i = 0; i < buckets.size(); ++i) run_bucket(i, 0);
+    }
+    if (!keys.empty() && !pending.empty()) {
+      std::lock_guard lock{rec_cache_mutex};
+      for (auto i : pending)
+        rec_cache.Put(keys[i], lines[i], lines[i].text.size());
     }
+    for (const auto& slot : rec_slots) {
+      stage.rec_preprocess_ns += slot.timing.rec_preprocess_ns;
+      stage.rec_run_ns += slot.timing.rec_run_ns;
+      stage.rec_postprocess_ns += slot.timing.rec_postprocess_ns;
+      stage.rec_count += slot.timing.rec_count;
+    }
+    OCRFrameResult frame_result;
+    frame_result.results.resize(boxes.size());
     for (size_t i = 0; i < boxes.size(); ++i) {
-      auto& box = boxes[i];
-      rec_input_tensor = std::move(rec_input_tensors[i]);
-      rec_io_binding.BindInput(rec_input_name.c_str(), rec_input_tensor);
-      rec_io_binding.BindOutput(rec_output_name.c_str(), rec_memory_info);
-      // predict string
-      Ort::RunOptions rec_run_options{};
-      rec->Run(rec_run_options, rec_io_binding);
-      const auto& rec_outputs = rec_io_binding.GetOutputValues();
-      auto& rec_output_tensor = rec_outputs[0];
-      auto rec_output_shape =
-          rec_output_tensor.GetTensorTypeAndShapeInfo().GetShape();
-      const auto rec_output_tensor_size =
-          std::accumulate(rec_output_shape.begin(), rec_output_shape.end(),
-                          1llu, std::multiplies());
-      auto span = std::span(rec_output_tensor.GetTensorData<float>(),
-                            rec_output_tensor_size);
-      auto lines = RecPostProcess(span, rec_output_shape, confidence_threshold);
-      if (!lines.empty())
-        frame_result.results.emplace_back(box, lines[0].second,
-                                          std::move(lines[0].first));
+      frame_result.results[i].rect = boxes[i];
+      frame_result.results[i].confidence = 0.0f;
+    }
+    // 同一文本框的片段按从左到右的顺序拼接，置信度按字符数加权
+    for (size_t i = 0; i < segments.size();) {
+      const size_t box = segments[i].box;
+      auto& result = frame_result.results[box];
+      float score_sum = 0.0f;
+      uint32_t score_count = 0;
+      for (; i < segments.size() && segments[i].box == box; ++i) {
+        result.line.append(lines[i].text);
+        score_sum += lines[i].score_sum;
+        score_count += lines[i].score_count;
+      }
+      result.confidence =
+          score_count ? score_sum / static_cast<float>(score_count) : 0.0f;
     }
     return frame_result;
   }
+
+  RunResult Run(const cv::Mat& image, float confidence_threshold,
+                OCRRunTiming* timing) noexcept {
+    if (auto result = CheckImage(image); !result)
+      return std::unexpected(std::move(result.error()));
+    std::lock_guard lock{run_mutex};
+    OCRRunTiming unused;
+    auto& stage = timing ? (*timing = OCRRunTiming{}) : unused;
+    auto boxes = DetectBoxes(image, stage, timing != nullptr);
+    return RecognizeBoxes(image, boxes, confidence_threshold, stage,
+                          timing != nullptr);
+  }
+
+  OCRRecCacheStats RecCacheStats() const noexcept {
+    std::lock_guard lock{rec_cache_mutex};
+    return OCRRecCacheStats{.hits = rec_cache_hits,
+                            .misses = rec_cache_misses,
+                            .evictions = rec_cache.evictions(),
+                            .entries = rec_cache.size()};
+  }
+
+  std::vector<std::string> EndProfiling() noexcept {
+    std::lock_guard lock{run_mutex};
+    std::vector<std::string> files;
+    for (auto [session, allocator] : {std::pair{det.get(), &det_allocator},
+                                      std::pair{rec.get(), &rec_allocator}}) {
+      try {
+        auto path = session->EndProfilingAllocated(*allocator);
+        if (path && *path.get()) files.emplace_back(path.get());
+      } catch (Ort::Exception& _) {
+      }
+    }
+    return files;
+  }
+
+  DetectResult Detect(const cv::Mat& image, OCRRunTiming* timing) noexcept {
+    if (auto result = CheckImage(image); !result)
+      return std::unexpected(std::move(result.error()));
+    std::lock_guard lock{run_mutex};
+    OCRRunTiming unused;
+    auto& stage = timing ? (*timing = OCRRunTiming{}) : unused;
+    return DetectBoxes(image, stage, timing != nullptr);
+  }
+
+  RunResult Recognize(const cv::Mat& image, std::span<const cv::Rect> boxes,
+                      float confidence_threshold,
+                      OCRRunTiming* timing) noexcept {
+    if (auto result = CheckImage(image); !result)
+      return std::unexpected(std::move(result.error()));
+    std::lock_guard lock{run_mutex};
+    OCRRunTiming unused;
+    auto& stage = timing ? (*timing = OCRRunTiming{}) : unused;
+    const cv::Rect bounds{0, 0, image.cols, image.rows};
+    std::vector<cv::Rect> clipped;
+    clipped.reserve(boxes.size());
+    for (const auto& box : boxes) clipped.emplace_back(box & bounds);
+    return RecognizeBoxes(image, clipped, confidence_threshold, stage,
+                          timing != nullptr);
+  }
+
+  std::vector<RunResult> RunBatch(std::span<const cv::Mat> images,
+                                  float confidence_threshold,
+                                  OCRRunTiming* timing) noexcept {
+    std::lock_guard lock{run_mutex};
+    std::vector<RunResult> results(images.size());
+    const bool timed = timing != nullptr;
+    OCRRunTiming det_stage, rec_stage;
+    // det输入尺寸相同的图片合并为一次det推理
+    struct DetGroup {
+      cv::Size input_size;
+      std::vector<const cv::Mat*> images;
+      std::vector<size_t> indices;
+    };
+    std::vector<DetGroup> groups;
+    for (size_t i = 0; i < images.size(); ++i) {
+      if (auto result = CheckImage(images[i]); !result) {
+        results[i] = std::unexpected(std::move(result.error()));
+        continue;
+      }
+      const auto input_size = DetInputSize(images[i].size());
+      auto it = std::ranges::find_if(groups, [&](const DetGroup& group) {
+        return group.input_size == input_size &&
+               group.images.size() < options.det_batch_size;
+      });
+      if (it == groups.end())
+        it = groups.insert(groups.end(), DetGroup{input_size, {}, {}});
+      it->images.emplace_back(&images[i]);
+      it->indices.emplace_back(i);
+    }
+    if (groups.empty()) return results;
+    using DetOutput = std::vector<std::vector<cv::Rect>>;
+    auto detect = [&](const DetGroup& group) -> DetOutput {
+      return DetectBoxes(group.images, group.input_size, det_stage, timed);
+    };
+    // 下一组的det在pipeline线程上执行，同时在调用线程上执行当前组的rec
+    auto next = detect(groups[0]);
+    for (size_t g = 0; g < groups.size(); ++g) {
+      auto current = std::move(next);
+      std::promise<DetOutput> promise;
+      auto future = promise.get_future();
+      const bool pipelined = g + 1 < groups.size();
+      if (pipelined)
+        pipeline_pool.Submit([&detect, &promise, &groups, g] {
+          promise.set_value(detect(groups[g + 1]));
+        });
+      const auto& group = groups[g];
+      for (size_t k = 0; k < group.indices.size(); ++k)
+        results[group.indices[k]] =
+            RecognizeBoxes(*group.images[k], current[k], confidence_threshold,
+                           rec_stage, timed);
+      if (pipelined) next = future.get();
+    }
+    if (timing) {
+      *timing = det_stage;
+      timing->rec_preprocess_ns = rec_stage.rec_preprocess_ns;
+      timing->rec_run_ns = rec_stage.rec_run_ns;
+      timing->rec_postprocess_ns = rec_stage.rec_postprocess_ns;
+      timing->rec_count = rec_stage.rec_count;
+    }
+    return results;
+  }
 };
 
 vision_simple::InferOCROrtPaddleImpl::InferOCROrtPaddleImpl(
     InferContextORT& ort_ctx, OCRModelType model_type,
     std::map<int, std::string> char_dict, std::unique_ptr<Ort::Session> det,
-    std::unique_ptr<Ort::Session> rec)
-    : impl_(std::make_unique<Impl>(ort_ctx, model_type, char_dict,
-                                   std::move(det), std::move(rec))) {}
+    std::unique_ptr<Ort::Session> rec, const OCROptions& options,
+    const OrtQuantParams& det_output_quant,
+    const OrtQuantParams& rec_output_quant)
+    : impl_(std::make_unique<Impl>(ort_ctx, model_type, std::move(char_dict),
+                                   std::move(det), std::move(rec), options,
+                                   det_output_quant, rec_output_quant)) {}
 
 vision_simple::OCRModelType vision_simple::InferOCROrtPaddleImpl::model_type()
     const noexcept {
@@ -314,6 +948,37 @@ vision_simple::OCRModelType vision_simple::InferOCROrtPaddleImpl::model_type()
 }
 
 vision_simple::InferOCR::RunResult vision_simple::InferOCROrtPaddleImpl::Run(
-    const cv::Mat& image, float confidence_threshold) noexcept {
-  return this->impl_->Run(image, confidence_threshold);
+    const cv::Mat& image, float confidence_threshold,
+    OCRRunTiming* timing) noexcept {
+  return this->impl_->Run(image, confidence_threshold, timing);
+}
+
+vision_simple::InferOCR::DetectResult
+vision_simple::InferOCROrtPaddleImpl::Detect(const cv::Mat& image,
+                                             OCRRunTiming* timing) noexcept {
+  return this->impl_->Detect(image, timing);
+}
+
+vision_simple::InferOCR::RunResult
+vision_simple::InferOCROrtPaddleImpl::Recognize(
+    const cv::Mat& image, std::span<const cv::Rect> boxes,
+    float confidence_threshold, OCRRunTiming* timing) noexcept {
+  return this->impl_->Recognize(image, boxes, confidence_threshold, timing);
+}
+
+std::vector<vision_simple::InferOCR::RunResult>
+vision_simple::InferOCROrtPaddleImpl::RunBatch(
+    std::span<const cv::Mat> images, float confidence_threshold,
+    OCRRunTiming* timing) noexcept {
+  return this->impl_->RunBatch(images, confidence_threshold, timing);
+}
+
+vision_simple::OCRRecCacheStats
+vision_simple::InferOCROrtPaddleImpl::rec_cache_stats() const noexcept {
+  return this->impl_->RecCacheStats();
+}
+
+std::vector<std::string>
+vision_simple::InferOCROrtPaddleImpl::EndProfiling() noexcept {
+  return this->impl_->EndProfiling();
 }
@@ -4,6 +4,7 @@
 namespace vision_simple
 {
     class InferContextORT;
+    struct OrtQuantParams;
 
     class InferOCROrtPaddleImpl final : public InferOCR
     {
@@ -14,9 +15,23 @@ namespace vision_simple
         explicit InferOCROrtPaddleImpl(InferContextORT& ort_ctx, OCRModelType model_type,
                                        std::map<int, std::string> char_dict,
                                        std::unique_ptr<Ort::Session> det,
-                                       std::unique_ptr<Ort::Session> rec);
+                                       std::unique_ptr<Ort::Session> rec,
+                                       const OCROptions& options,
+                                       const OrtQuantParams& det_output_quant,
+                                       const OrtQuantParams& rec_output_quant);
 
         OCRModelType model_type() const noexcept override;
-        RunResult Run(const cv::Mat& image, float confidence_threshold) noexcept override;
+        RunResult Run(const cv::Mat& image, float confidence_threshold,
+                      OCRRunTiming* timing = nullptr) noexcept override;
+        DetectResult Detect(const cv::Mat& image,
+                            OCRRunTiming* timing = nullptr) noexcept override;
+        RunResult Recognize(const cv::Mat& image, std::span<const cv::Rect> boxes,
+                            float confidence_threshold,
+                            OCRRunTiming* timing = nullptr) noexcept override;
+        std::vector<RunResult> RunBatch(std::span<const cv::Mat> images,
+                                        float confidence_threshold,
+                                        OCRRunTiming* timing = nullptr) noexcept override;
+        OCRRecCacheStats rec_cache_stats() const noexcept override;
+        std::vector<std::string> EndProfiling() noexcept override;
     };
 }
@@ -7,7 +7,28 @@
 #endif
 #include <onnxruntime_session_options_config_keys.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
 #include <magic_enum.hpp>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "Hash.h"
+#include "HugePage.h"
+#include "VisionHelper.hpp"
 
 #define INFER_CTX_LOG_ID "vision-simple"
 #ifdef VISION_SIMPLE_DEBUG
@@ -21,13 +42,598 @@
                         std::format("unsupported execution_provider:{}", \
                                     magic_enum::enum_name((ep)))}}
 
+namespace {
+using namespace vision_simple;
+
+// 吞吐预设下每个session的intra-op线程数
+constexpr int THROUGHPUT_INTRA_OP_THREADS = 2;
+// 自动调优时每个候选配置的预热和计时推理次数
+constexpr int AUTOTUNE_WARMUP_RUNS = 2;
+constexpr int AUTOTUNE_RUNS = 8;
+// 吞吐目标下同时测量的session实例数上限，限制调优时的内存占用
+constexpr int AUTOTUNE_MAX_INSTANCES = 16;
+// 合成输入中动态维度的取值：batch维取1，其余取det/YOLO常用的输入边长
+constexpr int64_t AUTOTUNE_DYNAMIC_DIM = 640;
+
+struct SessionTuning {
+  // 0为ORT默认值
+  int intra_op_threads{0};
+  int inter_op_threads{0};
+  bool allow_spinning{false};
+  ExecutionMode execution_mode{ORT_SEQUENTIAL};
+  bool mem_pattern{true};
+  GraphOptimizationLevel graph_optimization_level{ORT_ENABLE_ALL};
+  bool denormal_as_zero{false};
+  bool cpu_arena{true};
+  InferAutoTune autotune{InferAutoTune::kOff};
+};
+
+struct GlobalThreadPools {
+  bool enabled{false};
+  // 0为ORT默认值
+  int intra_op_threads{0};
+  int inter_op_threads{0};
+  bool allow_spinning{false};
+  std::string intra_op_affinity;
+};
+
+struct HugePageSettings {
+  bool enabled{false};
+  HugePageMode mode{HugePageMode::kTransparent};
+  int max_cached_mb{
+      static_cast<int>(HugePagePool::DEFAULT_MAX_CACHED_BYTES >> 20)};
+};
+
+/**
+ * 查找参数，overrides中的同名键优先
+ */
+const std::string* FindArg(const InferArgs& args, const InferArgs& overrides,
+                           std::string_view key) {
+  const std::string key_str{key};
+  if (auto it = overrides.find(key_str); it != overrides.end())
+    return &it->second;
+  if (auto it = args.find(key_str); it != args.end()) return &it->second;
+  return nullptr;
+}
+
+auto InvalidArg(std::string_view key, const std::string& value) {
+  return MK_VSERROR(VisionSimpleErrorCode::kParameterError,
+                    std::format("invalid infer arg {}:{}", key, value));
+}
+
+// 非负整数
+VSResult<void> ParseCountArg(std::string_view key, const std::string* value,
+                             int& target) {
+  if (!value) return {};
+  const auto end = value->data() + value->size();
+  if (auto [ptr, ec] = std::from_chars(value->data(), end, target);
+      ec != std::errc{} || ptr != end || target < 0)
+    return InvalidArg(key, *value);
+  return {};
+}
+
+// "1"/"0"
+VSResult<void> ParseSwitchArg(std::string_view key, const std::string* value,
+                              bool& target) {
+  if (!value) return {};
+  if (*value != "0" && *value != "1") return InvalidArg(key, *value);
+  target = *value == "1";
+  return {};
+}
+
+/**
+ * 合并context和模型的args，解析为session调优参数
+ * @param overrides 模型级args，同名键覆盖context的args
+ */
+VSResult<SessionTuning> ParseSessionTuning(const InferArgs& args,
+                                           const InferArgs& overrides) {
+  auto find = [&](std::string_view key) {
+    return FindArg(args, overrides, key);
+  };
+  SessionTuning tuning;
+  if (auto value = find(INFER_ARG_KEY_SESSION_PRESET)) {
+    auto preset = magic_enum::enum_cast<InferSessionPreset>(*value);
+    if (!preset) return InvalidArg(INFER_ARG_KEY_SESSION_PRESET, *value);
+    if (*preset == InferSessionPreset::kLatency) {
+      tuning.allow_spinning = true;
+    } else if (*preset == InferSessionPreset::kThroughput) {
+      tuning.intra_op_threads = THROUGHPUT_INTRA_OP_THREADS;
+      tuning.inter_op_threads = 1;
+    }
+  }
+  for (auto [key, target] :
+       {std::pair{INFER_ARG_KEY_INTRA_OP_THREADS, &tuning.intra_op_threads},
+        std::pair{INFER_ARG_KEY_INTER_OP_THREADS, &tuning.inter_op_threads}})
+    if (auto result = ParseCountArg(key, find(key), *target); !result)
+      return std::unexpected(std::move(result.error()));
+  for (auto [key, target] :
+       {std::pair{INFER_ARG_KEY_ALLOW_SPINNING, &tuning.allow_spinning},
+        std::pair{INFER_ARG_KEY_MEM_PATTERN, &tuning.mem_pattern},
+        std::pair{INFER_ARG_KEY_DENORMAL_AS_ZERO, &tuning.denormal_as_zero},
+        std::pair{INFER_ARG_KEY_CPU_ARENA, &tuning.cpu_arena}})
+    if (auto result = ParseSwitchArg(key, find(key), *target); !result)
+      return std::unexpected(std::move(result.error()));
+  if (auto value = find(INFER_ARG_KEY_EXECUTION_MODE)) {
+    auto mode = magic_enum::enum_cast<ExecutionMode>(*value);
+    if (!mode) return InvalidArg(INFER_ARG_KEY_EXECUTION_MODE, *value);
+    tuning.execution_mode = *mode;
+  }
+  if (auto value = find(INFER_ARG_KEY_GRAPH_OPTIMIZATION_LEVEL)) {
+    auto level = magic_enum::enum_cast<GraphOptimizationLevel>(*value);
+    if (!level) return InvalidArg(INFER_ARG_KEY_GRAPH_OPTIMIZATION_LEVEL, *value);
+    tuning.graph_optimization_level = *level;
+  }
+  if (auto value = find(INFER_ARG_KEY_AUTOTUNE)) {
+    auto autotune = magic_enum::enum_cast<InferAutoTune>(*value);
+    if (!autotune) return InvalidArg(INFER_ARG_KEY_AUTOTUNE, *value);
+    tuning.autotune = *autotune;
+  }
+  return tuning;
+}
+
+VSResult<GlobalThreadPools> ParseGlobalThreadPools(const InferArgs& args) {
+  auto find = [&](std::string_view key) { return FindArg(args, {}, key); };
+  GlobalThreadPools pools;
+  for (auto [key, target] :
+       {std::pair{INFER_ARG_KEY_GLOBAL_THREAD_POOLS, &pools.enabled},
+        std::pair{INFER_ARG_KEY_GLOBAL_ALLOW_SPINNING, &pools.allow_spinning}})
+    if (auto result = ParseSwitchArg(key, find(key), *target); !result)
+      return std::unexpected(std::move(result.error()));
+  for (auto [key, target] :
+       {std::pair{INFER_ARG_KEY_GLOBAL_INTRA_OP_THREADS,
+                  &pools.intra_op_threads},
+        std::pair{INFER_ARG_KEY_GLOBAL_INTER_OP_THREADS,
+                  &pools.inter_op_threads}})
+    if (auto result = ParseCountArg(key, find(key), *target); !result)
+      return std::unexpected(std::move(result.error()));
+  if (auto value = find(INFER_ARG_KEY_GLOBAL_INTRA_OP_AFFINITY))
+    pools.intra_op_affinity = *value;
+  return pools;
+}
+
+VSResult<HugePageSettings> ParseHugePageSettings(const InferArgs& args) {
+  auto find = [&](std::string_view key) { return FindArg(args, {}, key); };
+  HugePageSettings settings;
+  if (auto result = ParseSwitchArg(INFER_ARG_KEY_HUGE_PAGE_ALLOCATOR,
+                                   find(INFER_ARG_KEY_HUGE_PAGE_ALLOCATOR),
+                                   settings.enabled);
+      !result)
+    return std::unexpected(std::move(result.error()));
+  if (auto result = ParseCountArg(INFER_ARG_KEY_HUGE_PAGE_MAX_CACHED_MB,
+                                  find(INFER_ARG_KEY_HUGE_PAGE_MAX_CACHED_MB),
+                                  settings.max_cached_mb);
+      !result)
+    return std::unexpected(std::move(result.error()));
+  if (auto value = find(INFER_ARG_KEY_HUGE_PAGE_MODE)) {
+    auto mode = magic_enum::enum_cast<HugePageMode>(*value);
+    if (!mode) return InvalidArg(INFER_ARG_KEY_HUGE_PAGE_MODE, *value);
+    settings.mode = *mode;
+  }
+  return settings;
+}
+
+/**
+ * 从HugePagePool分配的ORT分配器，env内的session共享
+ */
+struct HugePageOrtAllocator : OrtAllocator {
+  Ort::MemoryInfo memory_info{
+      Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault)};
+
+  HugePageOrtAllocator() : OrtAllocator{} {
+    version = ORT_API_VERSION;
+    OrtAllocator::Alloc = [](OrtAllocator*, size_t size) noexcept -> void* {
+      try {
+        return HugePagePool::Instance().Allocate(size);
+      } catch (std::bad_alloc&) {
+        return nullptr;
+      }
+    };
+    OrtAllocator::Free = [](OrtAllocator*, void* ptr) noexcept {
+      HugePagePool::Instance().Free(ptr);
+    };
+    OrtAllocator::Info = [](const OrtAllocator* self) noexcept {
+      return static_cast<const OrtMemoryInfo*>(
+          static_cast<const HugePageOrtAllocator*>(self)->memory_info);
+    };
+  }
+};
+
+// 与内存池一样不析构，env可能晚于context释放
+HugePageOrtAllocator& SharedHugePageOrtAllocator() {
+  static auto* allocator = new HugePageOrtAllocator();
+  return *allocator;
+}
+
+/**
+ * 与EP无关的session选项
+ * @param global_thread_pools 为true时线程数和spinning由env的全局线程池决定
+ */
+Ort::SessionOptions CpuSessionOptions(const SessionTuning& tuning,
+                                      bool global_thread_pools) {
+  Ort::SessionOptions session_options;
+  session_options.SetGraphOptimizationLevel(tuning.graph_optimization_level);
+  if (global_thread_pools) {
+    // 线程数和spinning由env的全局线程池决定
+    session_options.DisablePerSessionThreads();
+  } else {
+    session_options.SetIntraOpNumThreads(tuning.intra_op_threads);
+    session_options.SetInterOpNumThreads(tuning.inter_op_threads);
+  }
+  session_options.SetExecutionMode(tuning.execution_mode);
+  if (!tuning.mem_pattern) session_options.DisableMemPattern();
+  if (tuning.cpu_arena) {
+    session_options.AddConfigEntry(kOrtSessionOptionsConfigUseEnvAllocators,
+                                   "1");
+  } else {
+    session_options.DisableCpuMemArena();
+  }
+  if (!global_thread_pools) {
+    const auto spinning = tuning.allow_spinning ? "1" : "0";
+    session_options.AddConfigEntry(
+        kOrtSessionOptionsConfigAllowInterOpSpinning, spinning);
+    session_options.AddConfigEntry(
+        kOrtSessionOptionsConfigAllowIntraOpSpinning, spinning);
+  }
+  if (tuning.denormal_as_zero)
+    session_options.AddConfigEntry(kOrtSessionOptionsConfigSetDenormalAsZero,
+                                   "1");
+  session_options.AddConfigEntry(kOrtSessionOptionsDisableCPUEPFallback, "0");
+  session_options.SetLogSeverityLevel(INFER_CTX_LOG_LEVEL);
+  return session_options;
+}
+
+int HardwareThreads() noexcept {
+  return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+/**
+ * CPU型号，同型号的节点共享调优结果和优化后的模型
+ */
+std::string CpuModelName() {
+  std::string name;
+#ifdef _WIN32
+  if (auto identifier = std::getenv("PROCESSOR_IDENTIFIER")) name = identifier;
+#else
+  // x86_64为model name，arm64为CPU implementer/part，riscv64为isa/uarch
+  constexpr std::array<std::string_view, 6> KEYS = {
+      "model name", "Hardware", "CPU implementer", "CPU part", "isa", "uarch"};
+  std::array<bool, KEYS.size()> found{};
+  std::ifstream cpuinfo{"/proc/cpuinfo"};
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    const auto colon = line.find(':');
+    if (colon == std::string::npos) continue;
+    auto key = std::string_view{line}.substr(0, colon);
+    while (!key.empty() && (key.back() == ' ' || key.back() == '\t'))
+      key.remove_suffix(1);
+    for (size_t i = 0; i < KEYS.size(); ++i) {
+      if (found[i] || key != KEYS[i]) continue;
+      found[i] = true;
+      name.append(line, colon + 1);
+      name.push_back(';');
+    }
+  }
+#endif
+  return name;
+}
+
+/**
+ * 调优结果的索引：模型数据、CPU型号、ORT版本、调优目标和影响测量的参数共同决定
+ */
+std::string AutoTuneKey(std::span<const uint8_t> data,
+                        const SessionTuning& tuning, bool global_thread_pools) {
+  static const auto cpu_model =
+      std::format("{}|{}", CpuModelName(), HardwareThreads());
+  auto hash = Hash64(data);
+  hash = HashCombine(hash, Hash64(cpu_model));
+  hash = HashCombine(hash, Hash64(Ort::GetVersionString()));
+  hash = HashCombine(hash, static_cast<uint64_t>(tuning.autotune));
+  hash = HashCombine(hash,
+                     static_cast<uint64_t>(tuning.graph_optimization_level));
+  hash = HashCombine(hash, global_thread_pools ? 1 : 0);
+  return std::format("{:016x}", hash);
+}
+
+// 调优结果格式："<intra_op_threads> <inter_op_threads> <execution_mode>"
+std::string FormatAutoTuneResult(const SessionTuning& tuning) {
+  return std::format("{} {} {}", tuning.intra_op_threads,
+                     tuning.inter_op_threads,
+                     magic_enum::enum_name(tuning.execution_mode));
+}
+
+bool ParseAutoTuneResult(const std::string& result, SessionTuning& tuning) {
+  std::istringstream in{result};
+  int intra_op_threads, inter_op_threads;
+  std::string mode_name;
+  if (!(in >> intra_op_threads >> inter_op_threads >> mode_name) ||
+      intra_op_threads < 0 || inter_op_threads < 0)
+    return false;
+  auto mode = magic_enum::enum_cast<ExecutionMode>(mode_name);
+  if (!mode) return false;
+  tuning.intra_op_threads = intra_op_threads;
+  tuning.inter_op_threads = inter_op_threads;
+  tuning.execution_mode = *mode;
+  return true;
+}
+
+std::vector<SessionTuning> AutoTuneCandidates(const SessionTuning& base,
+                                              bool global_thread_pools) {
+  std::vector<SessionTuning> candidates;
+  auto add = [&](int intra_op_threads, int inter_op_threads,
+                 ExecutionMode mode) {
+    auto& candidate = candidates.emplace_back(base);
+    candidate.intra_op_threads = intra_op_threads;
+    candidate.inter_op_threads = inter_op_threads;
+    candidate.execution_mode = mode;
+  };
+  if (global_thread_pools) {
+    // 线程数由全局线程池决定，只比较执行模式
+    add(base.intra_op_threads, base.inter_op_threads, ORT_SEQUENTIAL);
+    add(base.intra_op_threads, base.inter_op_threads, ORT_PARALLEL);
+    return candidates;
+  }
+  const int hardware_threads = HardwareThreads();
+  for (int threads = 1; threads < hardware_threads; threads *= 2)
+    add(threads, 1, ORT_SEQUENTIAL);
+  add(hardware_threads, 1, ORT_SEQUENTIAL);
+  // 多分支的图(如多个输出头)可能受益于算子间并行
+  add(hardware_threads, 2, ORT_PARALLEL);
+  return candidates;
+}
+
+struct SyntheticInputs {
+  std::vector<std::string> input_names, output_names;
+  std::vector<const char*> input_name_ptrs, output_name_ptrs;
+  std::vector<Ort::Value> inputs;
+};
+
+/**
+ * 按模型的输入形状生成全零输入，含非张量或不支持的元素类型时返回空
+ */
+std::optional<SyntheticInputs> MakeSyntheticInputs(Ort::Session& session) {
+  Ort::AllocatorWithDefaultOptions allocator;
+  SyntheticInputs synthetic;
+  for (size_t i = 0; i < session.GetInputCount(); ++i) {
+    auto type_info = session.GetInputTypeInfo(i);
+    if (type_info.GetONNXType() != ONNX_TYPE_TENSOR) return std::nullopt;
+    auto tensor_info = type_info.GetTensorTypeAndShapeInfo();
+    const auto element_type = tensor_info.GetElementType();
+    const auto element_size = OrtElementSize(element_type);
+    if (element_size == 0) return std::nullopt;
+    auto shape = tensor_info.GetShape();
+    for (size_t d = 0; d < shape.size(); ++d)
+      if (shape[d] <= 0) shape[d] = d == 0 ? 1 : AUTOTUNE_DYNAMIC_DIM;
+    auto value = Ort::Value::CreateTensor(allocator, shape.data(),
+                                          shape.size(), element_type);
+    std::memset(value.GetTensorMutableRawData(), 0,
+                value.GetTensorTypeAndShapeInfo().GetElementCount() *
+                    element_size);
+    synthetic.inputs.emplace_back(std::move(value));
+    synthetic.input_names.emplace_back(
+        session.GetInputNameAllocated(i, allocator).get());
+  }
+  for (size_t i = 0; i < session.GetOutputCount(); ++i)
+    synthetic.output_names.emplace_back(
+        session.GetOutputNameAllocated(i, allocator).get());
+  for (const auto& name : synthetic.input_names)
+    synthetic.input_name_ptrs.emplace_back(name.c_str());
+  for (const auto& name : synthetic.output_names)
+    synthetic.output_name_ptrs.emplace_back(name.c_str());
+  return synthetic;
+}
+
+/**
+ * 模型实例上的调用是串行的(见Infer.h)，吞吐目标下每个实例只由一个线程调用，
+ * 以多个实例并发模拟多模型同时推理
+ * @param sessions 同一候选配置的实例，kLatency只使用第一个
+ * @return kLatency为单次推理的中位耗时，kThroughput为平均每次推理占用的
+ * 墙钟时间，单位毫秒，越小越好
+ * @throw Ort::Exception 推理失败
+ */
+double MeasureSession(std::span<Ort::Session> sessions,
+                      const SyntheticInputs& synthetic,
+                      InferAutoTune objective) {
+  using clock = std::chrono::steady_clock;
+  auto run_once = [&](Ort::Session& session) {
+    session.Run(Ort::RunOptions{nullptr}, synthetic.input_name_ptrs.data(),
+                synthetic.inputs.data(), synthetic.inputs.size(),
+                synthetic.output_name_ptrs.data(),
+                synthetic.output_name_ptrs.size());
+  };
+  for (auto& session : sessions)
+    for (int i = 0; i < AUTOTUNE_WARMUP_RUNS; ++i) run_once(session);
+  if (objective == InferAutoTune::kLatency) {
+    std::array<double, AUTOTUNE_RUNS> samples{};
+    for (auto& sample : samples) {
+      const auto start = clock::now();
+      run_once(sessions.front());
+      sample = std::chrono::duration<double, std::milli>(clock::now() - start)
+                   .count();
+    }
+    std::ranges::nth_element(samples, samples.begin() + AUTOTUNE_RUNS / 2);
+    return samples[AUTOTUNE_RUNS / 2];
+  }
+  std::atomic<bool> failed{false};
+  const auto start = clock::now();
+  {
+    std::vector<std::jthread> threads;
+    threads.reserve(sessions.size());
+    for (auto& session : sessions)
+      threads.emplace_back([&] {
+        try {
+          for (int i = 0; i < AUTOTUNE_RUNS && !failed; ++i) run_once(session);
+        } catch (std::exception& _) {
+          failed = true;
+        }
+      });
+  }
+  if (failed) throw std::runtime_error("autotune run failed");
+  return std::chrono::duration<double, std::milli>(clock::now() - start)
+             .count() /
+         static_cast<double>(sessions.size() * AUTOTUNE_RUNS);
+}
+
+/**
+ * 逐个创建候选配置的session并测量，返回最优的配置，所有候选都失败时返回空
+ */
+std::optional<SessionTuning> AutoTuneSession(Ort::Env& env,
+                                             std::span<const uint8_t> data,
+                                             const SessionTuning& base,
+                                             bool global_thread_pools) {
+  // 同时加载的模型依次调优，避免互相抢占CPU影响测量
+  static std::mutex mutex;
+  std::lock_guard lock{mutex};
+  const int hardware_threads = HardwareThreads();
+  std::optional<SyntheticInputs> synthetic;
+  std::optional<SessionTuning> best;
+  double best_ms = std::numeric_limits<double>::infinity();
+  for (const auto& candidate : AutoTuneCandidates(base, global_thread_pools)) {
+    try {
+      // 吞吐目标下按候选的线程数创建足够的实例用满所有逻辑核
+      const int threads = candidate.intra_op_threads > 0
+                              ? candidate.intra_op_threads
+                              : hardware_threads;
+      const int instances =
+          base.autotune == InferAutoTune::kThroughput && !global_thread_pools
+              ? std::clamp(hardware_threads / threads, 1,
+                           AUTOTUNE_MAX_INSTANCES)
+              : 1;
+      const auto session_options =
+          CpuSessionOptions(candidate, global_thread_pools);
+      std::vector<Ort::Session> sessions;
+      sessions.reserve(instances);
+      for (int i = 0; i < instances; ++i)
+        sessions.emplace_back(env, data.data(), data.size_bytes(),
+                              session_options);
+      if (!synthetic) {
+        synthetic = MakeSyntheticInputs(sessions.front());
+        if (!synthetic) {
+          std::cerr << std::format(
+                           "{}: autotune does not support the model inputs, "
+                           "using untuned session settings",
+                           INFER_CTX_LOG_ID)
+                    << std::endl;
+          return std::nullopt;
+        }
+      }
+      const double ms = MeasureSession(sessions, *synthetic, base.autotune);
+      if (ms < best_ms) {
+        best_ms = ms;
+        best = candidate;
+      }
+    } catch (std::exception& e) {
+      std::cerr << std::format("{}: autotune candidate \"{}\" failed:{}",
+                               INFER_CTX_LOG_ID,
+                               FormatAutoTuneResult(candidate), e.what())
+                << std::endl;
+    }
+  }
+  if (!best)
+    std::cerr << std::format(
+                     "{}: all autotune candidates failed, using untuned "
+                     "session settings",
+                     INFER_CTX_LOG_ID)
+              << std::endl;
+  return best;
+}
+
+/**
+ * 优化后模型的缓存文件名：模型数据、CPU型号、ORT版本、EP和影响图优化的参数
+ * 共同决定。ORT_ENABLE_ALL的布局变换与指令集相关(如NCHWc的块大小)，
+ * 多种机型共享缓存目录时不能互相复用
+ */
+std::string ModelCacheFileName(std::span<const uint8_t> data, InferEP ep,
+                               size_t device_id,
+                               const SessionTuning& tuning) {
+  static const auto cpu_model = CpuModelName();
+  auto hash = Hash64(data);
+  hash = HashCombine(hash, Hash64(cpu_model));
+  hash = HashCombine(hash, Hash64(Ort::GetVersionString()));
+  hash = HashCombine(hash, static_cast<uint64_t>(ep));
+  hash = HashCombine(hash, device_id);
+  hash = HashCombine(hash,
+                     static_cast<uint64_t>(tuning.graph_optimization_level));
+  return std::format("{:016x}.ort", hash);
+}
+
+/**
+ * 进程内共享的prepack权重容器，最后一个context析构时释放
+ */
+std::shared_ptr<Ort::PrepackedWeightsContainer> SharedPrepackedWeights() {
+  static std::mutex mutex;
+  static std::weak_ptr<Ort::PrepackedWeightsContainer> shared;
+  std::lock_guard lock{mutex};
+  auto container = shared.lock();
+  if (!container) {
+    container = std::make_shared<Ort::PrepackedWeightsContainer>();
+    shared = container;
+  }
+  return container;
+}
+
+std::unique_ptr<Ort::Env> CreateEnv(const GlobalThreadPools& pools) {
+  if (!pools.enabled)
+    return std::make_unique<Ort::Env>(INFER_CTX_LOG_LEVEL, INFER_CTX_LOG_ID);
+  // 所有session共享同一组线程池，线程总数与加载的模型数量无关
+  Ort::ThreadingOptions threading_options;
+  threading_options.SetGlobalIntraOpNumThreads(pools.intra_op_threads);
+  threading_options.SetGlobalInterOpNumThreads(pools.inter_op_threads);
+  threading_options.SetGlobalSpinControl(pools.allow_spinning ? 1 : 0);
+  if (!pools.intra_op_affinity.empty())
+    Ort::ThrowOnError(Ort::GetApi().SetGlobalIntraOpThreadAffinity(
+        threading_options, pools.intra_op_affinity.c_str()));
+  return std::make_unique<Ort::Env>(threading_options, INFER_CTX_LOG_LEVEL,
+                                    INFER_CTX_LOG_ID);
+}
+}  // namespace
+
 vision_simple::InferContextORT::InferContextORT(const InferEP ep,
                                                 InferArgs args)
   : InferContext(InferFramework::kONNXRUNTIME, ep, std::move(args)),
-    env_(std::make_unique<Ort::Env>(INFER_CTX_LOG_LEVEL, INFER_CTX_LOG_ID)),
     env_memory_info_(
         Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)) {
-  env_->CreateAndRegisterAllocator(env_memory_info_, nullptr);
+  auto pools = ParseGlobalThreadPools(args_);
+  if (!pools) throw std::invalid_argument(pools.error().message.c_str());
+  global_thread_pools_ = pools->enabled;
+  env_ = CreateEnv(*pools);
+  prepacked_weights_ = SharedPrepackedWeights();
+  auto huge_pages = ParseHugePageSettings(args_);
+  if (!huge_pages)
+    throw std::invalid_argument(huge_pages.error().message.c_str());
+  if (huge_pages->enabled) {
+    HugePagePool::Instance().Configure(
+        huge_pages->mode, static_cast<size_t>(huge_pages->max_cached_mb) << 20);
+    auto& allocator = SharedHugePageOrtAllocator();
+    // 模型和io binding按此memory info查找分配器，需与注册的分配器一致
+    env_memory_info_ =
+        Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
+    env_->RegisterAllocator(&allocator);
+  } else {
+    env_->CreateAndRegisterAllocator(env_memory_info_, nullptr);
+  }
+  if (auto it = args_.find(std::string{INFER_ARG_KEY_MODEL_CACHE_DIR});
+      it != args_.end() && !it->second.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(it->second, ec);
+    if (ec)
+      throw std::invalid_argument(std::format(
+          "unable to create model cache dir {}:{}", it->second, ec.message()));
+    model_cache_ = std::make_unique<ModelCache>();
+    model_cache_->dir = it->second;
+  }
+  autotune_store_ = std::make_unique<AutoTuneStore>();
+  if (auto it = args_.find(std::string{INFER_ARG_KEY_AUTOTUNE_FILE});
+      it != args_.end() && !it->second.empty()) {
+    autotune_store_->file = it->second;
+    // 每行为"<键> <结果>"，同一个键后写入的结果优先
+    std::ifstream in{autotune_store_->file};
+    std::string line;
+    while (std::getline(in, line)) {
+      const auto space = line.find(' ');
+      if (space == std::string::npos) continue;
+      autotune_store_->entries[line.substr(0, space)] = line.substr(space + 1);
+    }
+  }
 }
 
 Ort::Env& vision_simple::InferContextORT::env() const noexcept { return *env_; }
@@ -36,20 +642,49 @@ Ort::MemoryInfo& vision_simple::InferContextORT::env_memory_info() {
   return env_memory_info_;
 }
 
+std::optional<std::string> vision_simple::InferContextORT::FindAutoTuneResult(
+    const std::string& key) const {
+  std::lock_guard lock{autotune_store_->mutex};
+  if (auto it = autotune_store_->entries.find(key);
+      it != autotune_store_->entries.end())
+    return it->second;
+  return std::nullopt;
+}
+
+void vision_simple::InferContextORT::SaveAutoTuneResult(
+    const std::string& key, const std::string& result) const {
+  std::lock_guard lock{autotune_store_->mutex};
+  autotune_store_->entries[key] = result;
+  if (autotune_store_->file.empty()) return;
+  std::ofstream out{autotune_store_->file, std::ios::app};
+  out << key << ' ' << result << '\n';
+}
+
 vision_simple::InferContextORT::CreateResult
-vision_simple::InferContextORT::CreateSession(std::span<uint8_t> data,
-                                              size_t device_id) const {
-  Ort::SessionOptions session_options;
-  session_options.SetGraphOptimizationLevel(
-      GraphOptimizationLevel::ORT_ENABLE_ALL);
-  session_options.DisableProfiling();
-  session_options.AddConfigEntry(kOrtSessionOptionsConfigUseEnvAllocators, "1");
-  session_options.AddConfigEntry(kOrtSessionOptionsConfigAllowInterOpSpinning,
-                                 "0");
-  session_options.AddConfigEntry(kOrtSessionOptionsConfigAllowIntraOpSpinning,
-                                 "0");
-  session_options.AddConfigEntry(kOrtSessionOptionsDisableCPUEPFallback, "0");
-  session_options.SetLogSeverityLevel(INFER_CTX_LOG_LEVEL);
+vision_simple::InferContextORT::CreateSession(
+    std::span<uint8_t> data, size_t device_id,
+    const InferArgs& session_args) const {
+  auto tuning = ParseSessionTuning(args_, session_args);
+  if (!tuning) return std::unexpected(std::move(tuning.error()));
+  if (tuning->autotune != InferAutoTune::kOff && ep_ == InferEP::kCPU) {
+    const auto key = AutoTuneKey(data, *tuning, global_thread_pools_);
+    if (auto result = FindAutoTuneResult(key);
+        !result || !ParseAutoTuneResult(*result, *tuning)) {
+      if (auto best =
+              AutoTuneSession(*env_, data, *tuning, global_thread_pools_)) {
+        *tuning = *best;
+        SaveAutoTuneResult(key, FormatAutoTuneResult(*tuning));
+      }
+    }
+  }
+  auto session_options = CpuSessionOptions(*tuning, global_thread_pools_);
+  if (auto prefix = FindArg(args_, session_args, INFER_ARG_KEY_PROFILE_PREFIX);
+      prefix && !prefix->empty()) {
+    session_options.EnableProfiling(
+        std::filesystem::path(*prefix).native().c_str());
+  } else {
+    session_options.DisableProfiling();
+  }
   if (ep_ == InferEP::kDML) {
 #ifndef VISION_SIMPLE_WITH_DML
     return UNSUPPORTED_EP(ep_);
@@ -126,12 +761,171 @@ vision_simple::InferContextORT::CreateSession(std::span<uint8_t> data,
     }
 #endif
   }
+  // 含编译节点的EP无法序列化优化后的图，只缓存CPU EP的模型
+  std::filesystem::path cache_path, cache_temp_path;
+  if (model_cache_ && ep_ == InferEP::kCPU) {
+    cache_path = model_cache_->dir /
+                 ModelCacheFileName(data, ep_, device_id, *tuning);
+    if (auto session = LoadCachedSession(cache_path, session_options))
+      return session;
+    // 先写临时文件再重命名，避免并发启动的进程读到不完整的文件
+    cache_temp_path = cache_path;
+    cache_temp_path += std::format(".{:08x}.tmp", std::random_device{}());
+    session_options.AddConfigEntry(kOrtSessionOptionsConfigSaveModelFormat,
+                                   "ORT");
+    session_options.SetOptimizedModelFilePath(cache_temp_path.c_str());
+  }
   try {
-    return std::make_unique<Ort::Session>(*env_, data.data(), data.size_bytes(),
-                                          session_options);
+    auto session = std::make_unique<Ort::Session>(
+        *env_, data.data(), data.size_bytes(), session_options,
+        *prepacked_weights_);
+    if (!cache_temp_path.empty()) {
+      std::error_code ec;
+      std::filesystem::rename(cache_temp_path, cache_path, ec);
+      if (ec) std::filesystem::remove(cache_temp_path, ec);
+    }
+    return session;
   } catch (std::exception& e) {
+    if (!cache_temp_path.empty()) {
+      std::error_code ec;
+      std::filesystem::remove(cache_temp_path, ec);
+    }
     return std::unexpected{VisionSimpleError{
         VisionSimpleErrorCode::kRuntimeError,
         std::format("unable to create ONNXRuntime Session:{}", e.what())}};
   }
 }
+
+std::unique_ptr<Ort::Session>
+vision_simple::InferContextORT::LoadCachedSession(
+    const std::filesystem::path& path,
+    const Ort::SessionOptions& session_options) const {
+  std::error_code ec;
+  const MappedFile* data;
+  {
+    std::lock_guard lock{model_cache_->mutex};
+    auto it = model_cache_->files.find(path.string());
+    if (it == model_cache_->files.end()) {
+      if (!std::filesystem::is_regular_file(path, ec)) return nullptr;
+      auto file = MappedFile::Open(path.string());
+      if (!file || file->size() == 0) return nullptr;
+      it = model_cache_->files.emplace(path.string(), std::move(*file)).first;
+    }
+    // unordered_map的节点地址在插入后保持不变
+    data = &it->second;
+  }
+  // 直接引用文件数据中的图和权重，不再复制，数据需与session同生命周期
+  auto options = session_options.Clone();
+  options.AddConfigEntry(kOrtSessionOptionsConfigLoadModelFormat, "ORT");
+  options.AddConfigEntry(kOrtSessionOptionsConfigUseORTModelBytesDirectly,
+                         "1");
+  options.AddConfigEntry(
+      kOrtSessionOptionsConfigUseORTModelBytesForInitializers, "1");
+  try {
+    return std::make_unique<Ort::Session>(*env_, data->span().data(),
+                                          data->size(), options,
+                                          *prepacked_weights_);
+  } catch (std::exception&) {
+    // 缓存文件损坏或版本不兼容时删除，随后重新生成；注册表项一并移除，
+    // 否则重新生成的文件会被旧映射遮蔽
+    std::lock_guard lock{model_cache_->mutex};
+    if (auto it = model_cache_->files.find(path.string());
+        it != model_cache_->files.end() && &it->second == data) {
+      model_cache_->retired.emplace_back(std::move(it->second));
+      model_cache_->files.erase(it);
+    }
+    std::filesystem::remove(path, ec);
+    return nullptr;
+  }
+}
+
+size_t vision_simple::OrtElementSize(ONNXTensorElementDataType type) noexcept {
+  switch (type) {
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL:
+      return 1;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16:
+      return 2;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32:
+      return 4;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+bool vision_simple::IsOrtQuantizedType(
+    ONNXTensorElementDataType type) noexcept {
+  return type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8 ||
+         type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+}
+
+vision_simple::InferResult<vision_simple::OrtQuantParams>
+vision_simple::ReadOutputQuantParams(Ort::Session& session) noexcept {
+  try {
+    const auto type =
+        session.GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetElementType();
+    if (!IsOrtQuantizedType(type)) return OrtQuantParams{};
+    Ort::AllocatorWithDefaultOptions allocator;
+    const auto metadata = session.GetModelMetadata();
+    auto lookup = [&](const char* key) -> std::optional<std::string> {
+      auto value = metadata.LookupCustomMetadataMapAllocated(key, allocator);
+      if (!value) return std::nullopt;
+      return std::string{value.get()};
+    };
+    auto scale = lookup("output_scale");
+    auto zero_point = lookup("output_zero_point");
+    if (!scale || !zero_point)
+      return MK_VSERROR(
+          VisionSimpleErrorCode::kModelError,
+          std::format("{} output requires output_scale and output_zero_point "
+                      "in model metadata",
+                      magic_enum::enum_name(type)));
+    OrtQuantParams params{std::stof(*scale), std::stoi(*zero_point)};
+    if (!(params.scale > 0.0f))
+      return MK_VSERROR(VisionSimpleErrorCode::kModelError,
+                        std::format("invalid output_scale:{}", *scale));
+    return params;
+  } catch (std::exception& e) {
+    return MK_VSERROR(
+        VisionSimpleErrorCode::kModelError,
+        std::format("unable to read output quantization:{}", e.what()));
+  }
+}
+
+const float* vision_simple::OrtTensorAsFloat(const Ort::Value& value,
+                                             const OrtQuantParams& quant,
+                                             std::vector<float>& cache) noexcept {
+  const auto info = value.GetTensorTypeAndShapeInfo();
+  const auto count = info.GetElementCount();
+  const auto type = info.GetElementType();
+  if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
+    return value.GetTensorData<float>();
+  if (cache.size() != count) cache.resize(count);
+  switch (type) {
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+      Cvt::cvt(std::span(value.GetTensorData<Ort::Float16_t>(), count),
+               cache.data());
+      break;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+      Cvt::dequantize(std::span(value.GetTensorData<uint8_t>(), count),
+                      quant.scale, quant.zero_point, cache.data());
+      break;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+      Cvt::dequantize(std::span(value.GetTensorData<int8_t>(), count),
+                      quant.scale, quant.zero_point, cache.data());
+      break;
+    default:
+      return nullptr;
+  }
+  return cache.data();
+}
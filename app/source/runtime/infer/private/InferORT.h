@@ -1,6 +1,11 @@
 ﻿#pragma once
+#include <filesystem>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <onnxruntime_cxx_api.h>
+#include <unordered_map>
+#include <vector>
 
 #include "../Infer.h"
 
@@ -8,11 +13,45 @@ namespace vision_simple
 {
     class InferContextORT : public InferContext
     {
+        struct ModelCache
+        {
+            std::filesystem::path dir;
+            std::mutex mutex;
+            // 缓存文件名到映射的注册表，同一模型的session共享一份映射，
+            // 直接引用其中的图和权重，映射在context生命周期内一直有效
+            std::unordered_map<std::string, MappedFile> files;
+            // 加载失败而移出注册表的映射，可能仍被已有session引用，保留到context析构
+            std::vector<MappedFile> retired;
+        };
+
+        struct AutoTuneStore
+        {
+            // 为空时不持久化
+            std::filesystem::path file;
+            std::mutex mutex;
+            // 调优键到结果，结果格式见InferORT.cpp
+            std::unordered_map<std::string, std::string> entries;
+        };
+
         std::unique_ptr<Ort::Env> env_;
         Ort::MemoryInfo env_memory_info_;
+        bool global_thread_pools_{false};
+        // 进程内所有context共享，相同权重的prepack结果只保留一份
+        std::shared_ptr<Ort::PrepackedWeightsContainer> prepacked_weights_;
+        // 未设置model_cache_dir时为空
+        std::unique_ptr<ModelCache> model_cache_;
+        std::unique_ptr<AutoTuneStore> autotune_store_;
+
+        std::unique_ptr<Ort::Session> LoadCachedSession(const std::filesystem::path& path,
+                                                        const Ort::SessionOptions& session_options) const;
+        std::optional<std::string> FindAutoTuneResult(const std::string& key) const;
+        void SaveAutoTuneResult(const std::string& key, const std::string& result) const;
 
     public:
         using CreateResult = InferResult<std::unique_ptr<Ort::Session>>;
+        /**
+         * @throw std::invalid_argument 全局线程池或大页分配器参数不合法
+         */
         InferContextORT(InferEP ep, InferArgs args);
         InferContextORT(const InferContextORT& other) = delete;
         InferContextORT(InferContextORT&& other) noexcept = default;
@@ -23,6 +62,35 @@ namespace vision_simple
         Ort::Env& env() const noexcept;
 
         [[nodiscard]] Ort::MemoryInfo& env_memory_info();
-        CreateResult CreateSession(std::span<uint8_t> data, size_t device_id) const;
+        /**
+         * @param session_args 模型级的session调优参数，覆盖context的args
+         */
+        CreateResult CreateSession(std::span<uint8_t> data, size_t device_id,
+                                   const InferArgs& session_args = {}) const;
     };
+
+    // uint8/int8张量的量化参数，real = (q - zero_point) * scale
+    struct OrtQuantParams
+    {
+        float scale{1.0f};
+        int32_t zero_point{0};
+    };
+
+    // 不支持的类型返回0
+    size_t OrtElementSize(ONNXTensorElementDataType type) noexcept;
+    bool IsOrtQuantizedType(ONNXTensorElementDataType type) noexcept;
+    /**
+     * 读取输出0的量化参数，输出不是uint8/int8时返回默认值
+     * ORT不暴露图中QuantizeLinear的常量，量化输出的模型需要在metadata_props中
+     * 写入output_scale和output_zero_point
+     */
+    InferResult<OrtQuantParams> ReadOutputQuantParams(Ort::Session& session) noexcept;
+    /**
+     * 将fp32/fp16/uint8/int8张量转为fp32，fp32张量直接返回其数据
+     * @param quant uint8/int8张量的量化参数
+     * @param cache 需要转换时的输出缓冲区
+     * @return 不支持的类型返回nullptr
+     */
+    const float* OrtTensorAsFloat(const Ort::Value& value, const OrtQuantParams& quant,
+                                  std::vector<float>& cache) noexcept;
 }
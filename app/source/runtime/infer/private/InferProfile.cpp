@@ -0,0 +1,62 @@
+#include <ylt/struct_json/json_reader.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "Infer.h"
+
+namespace {
+// ORT分析文件(chrome trace格式)中关心的字段，其余字段解析时跳过
+struct ProfileEventArgs {
+  std::string op_name;
+};
+
+struct ProfileEvent {
+  std::string cat;
+  std::string name;
+  int64_t dur;
+  ProfileEventArgs args;
+};
+
+// 每个节点记录fence_before/kernel_time/fence_after三个事件，只统计kernel
+constexpr std::string_view KERNEL_TIME_SUFFIX{"_kernel_time"};
+}  // namespace
+
+vision_simple::InferResult<std::vector<vision_simple::InferProfileOp>>
+vision_simple::SummarizeInferProfile(
+    std::span<const std::string> files) noexcept {
+  try {
+    std::unordered_map<std::string, InferProfileOp> ops;
+    for (const auto& file : files) {
+      auto content = ReadAllString(file);
+      if (!content) return std::unexpected(std::move(content.error()));
+      std::vector<ProfileEvent> events;
+      std::error_code ec;
+      struct_json::from_json(events, *content, ec);
+      if (ec)
+        return MK_VSERROR(
+            VisionSimpleErrorCode::kParameterError,
+            std::format("unable to parse profile {}:{}", file, ec.message()));
+      for (const auto& event : events) {
+        if (event.cat != "Node" || !event.name.ends_with(KERNEL_TIME_SUFFIX))
+          continue;
+        auto& op = ops[event.args.op_name];
+        op.op_type = event.args.op_name;
+        ++op.calls;
+        op.total_us += static_cast<uint64_t>(std::max<int64_t>(event.dur, 0));
+      }
+    }
+    std::vector<InferProfileOp> summary;
+    summary.reserve(ops.size());
+    for (auto& [_, op] : ops) {
+      op.avg_us = static_cast<double>(op.total_us) / static_cast<double>(op.calls);
+      summary.emplace_back(std::move(op));
+    }
+    std::ranges::sort(summary, [](const auto& a, const auto& b) {
+      return a.total_us > b.total_us;
+    });
+    return summary;
+  } catch (std::exception& e) {
+    return MK_VSERROR(VisionSimpleErrorCode::kRuntimeError, e.what());
+  }
+}
@@ -19,15 +19,17 @@ using namespace vision_simple;
 namespace {
 using InferYOLOFactory = std::function<InferYOLO::CreateResult(
     InferContext& context, std::span<uint8_t> data, YOLOVersion version,
-    size_t device_id)>;
+    size_t device_id, const InferArgs& session_args)>;
 
 std::map<InferFramework, InferYOLOFactory> infer_yolo_factories{std::make_pair(
     InferFramework::kONNXRUNTIME,
     [](InferContext& context, std::span<uint8_t> data, YOLOVersion version,
-       size_t device_id) -> InferYOLO::CreateResult {
+       size_t device_id,
+       const InferArgs& session_args) -> InferYOLO::CreateResult {
       auto& ort_ctx = dynamic_cast<InferContextORT&>(context);
       try {
-        auto session_opt = ort_ctx.CreateSession(data, device_id);
+        auto session_opt =
+            ort_ctx.CreateSession(data, device_id, session_args);
         if (!session_opt)
           return std::unexpected{std::move(session_opt.error())};
         Ort::Allocator allocator{**session_opt, ort_ctx.env_memory_info()};
@@ -55,9 +57,12 @@ std::map<InferFramework, InferYOLOFactory> infer_yolo_factories{std::make_pair(
               VisionSimpleErrorCode::kModelError,
               std::format("unable to find class names from model metadata")}};
         }
+        auto output_quant = ReadOutputQuantParams(**session_opt);
+        if (!output_quant)
+          return std::unexpected{std::move(output_quant.error())};
         return std::make_unique<InferYOLOOrtImpl>(
             ort_ctx, std::move(*session_opt), std::move(allocator), version,
-            std::move(*class_names_opt));
+            std::move(*class_names_opt), *output_quant);
       } catch (std::exception& e) {
         return std::unexpected{VisionSimpleError{
             VisionSimpleErrorCode::kRuntimeError,
@@ -69,10 +74,11 @@ std::map<InferFramework, InferYOLOFactory> infer_yolo_factories{std::make_pair(
 InferYOLO::CreateResult InferYOLO::Create(InferContext& context,
                                           std::span<uint8_t> data,
                                           YOLOVersion version,
-                                          size_t device_id) noexcept {
+                                          size_t device_id,
+                                          const InferArgs& session_args) noexcept {
   try {
-    return infer_yolo_factories.at(context.framework())(context, data, version,
-                                                        device_id);
+    return infer_yolo_factories.at(context.framework())(
+        context, data, version, device_id, session_args);
   } catch (std::exception& e) {
     return std::unexpected{VisionSimpleError{
         VisionSimpleErrorCode::kParameterError,
@@ -119,7 +125,7 @@ std::vector<YOLOResult> YOLOFilter::ApplyNMS(
   return result;
 }
 
-YOLOFrameResult YOLOFilter::v11(std::span<const float> infer_output,
+std::vector<YOLOResult> YOLOFilter::v11(std::span<const float> infer_output,
                                 float confidence_threshold, int img_width,
                                 int img_height, int orig_width,
                                 int orig_height) const noexcept {
@@ -159,11 +165,10 @@ YOLOFrameResult YOLOFilter::v11(std::span<const float> infer_output,
                               this->class_names_[object_class_id]);
     }
   }
-  auto nmsed_detections = ApplyNMS(detections, 0.3f);
-  return YOLOFrameResult{std::move(nmsed_detections)};
+  return detections;
 }
 
-YOLOFrameResult YOLOFilter::v10(std::span<const float> infer_output,
+std::vector<YOLOResult> YOLOFilter::v10(std::span<const float> infer_output,
                                 float confidence_threshold, int img_width,
                                 int img_height, int orig_width,
                                 int orig_height) const noexcept {
@@ -201,41 +206,52 @@ YOLOFrameResult YOLOFilter::v10(std::span<const float> infer_output,
                               confidence, this->class_names_[class_id]);
     }
   }
-  auto nmsed_detections = ApplyNMS(detections, 0.3f);
-  return YOLOFrameResult{nmsed_detections};
+  return detections;
 }
 
 YOLOFilter::FilterResult YOLOFilter::operator()(
     std::span<const float> infer_output, float confidence_threshold,
-    int img_width, int img_height, int orig_width,
-    int orig_height) const noexcept {
+    int img_width, int img_height, int orig_width, int orig_height,
+    YOLORunTiming* timing) const noexcept {
+  YOLORunTiming unused;
+  auto& stage = timing ? *timing : unused;
+  StageClock clock{timing != nullptr};
+  std::vector<YOLOResult> detections;
   if (version_ == YOLOVersion::kV10) {
-    return v10(infer_output, confidence_threshold, img_width, img_height,
-               orig_width, orig_height);
-  }
-  if (version_ == YOLOVersion::kV11) {
-    return v11(infer_output, confidence_threshold, img_width, img_height,
-               orig_width, orig_height);
+    detections = v10(infer_output, confidence_threshold, img_width, img_height,
+                     orig_width, orig_height);
+  } else if (version_ == YOLOVersion::kV11) {
+    detections = v11(infer_output, confidence_threshold, img_width, img_height,
+                     orig_width, orig_height);
+  } else {
+    return std::unexpected(VisionSimpleError{
+        VisionSimpleErrorCode::kParameterError,
+        std::format("unsupported version: {}",
+                    magic_enum::enum_name(version_))});
   }
-  return std::unexpected(VisionSimpleError{
-      VisionSimpleErrorCode::kParameterError,
-      std::format("unsupported version: {}", magic_enum::enum_name(version_))});
+  clock.Lap(stage.decode_ns);
+  auto nmsed_detections = ApplyNMS(detections, 0.3f);
+  clock.Lap(stage.nms_ns);
+  return YOLOFrameResult{std::move(nmsed_detections)};
 }
 
 cv::Mat& InferYOLOOrtImpl::PreProcess(const cv::Mat& image) noexcept {
   auto& dst_image = vision_helper_.Letterbox(image, input_size_);
-  // TODO: 根据模型输入，自动调整type
+  if (input_value_type_ == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8) {
+    // uint8输入直接写入张量，不做归一化
+    vision_helper_.HWC2CHW_BGR2RGB<uint8_t>(dst_image, input_tensor_image_);
+    return input_tensor_image_;
+  }
   vision_helper_.HWC2CHW_BGR2RGB<uint8_t>(dst_image, dst_image);
   return dst_image;
-  // dst_image.convertTo(preprocessed_image_, CV_32F, 1.0 / 255);
-  // return preprocessed_image_;
 }
 
 InferYOLOOrtImpl::InferYOLOOrtImpl(InferContextORT& ort_ctx,
                                    std::unique_ptr<Ort::Session>&& session,
                                    Ort::Allocator&& allocator,
                                    YOLOVersion version,
-                                   std::vector<std::string> class_names)
+                                   std::vector<std::string> class_names,
+                                   OrtQuantParams output_quant)
     : session_(std::move(session)),
       version_(version),
       filter_(version, class_names,
@@ -248,7 +264,8 @@ InferYOLOOrtImpl::InferYOLOOrtImpl(InferContextORT& ort_ctx,
       output_memory_info_(Ort::MemoryInfo::CreateCpu(
           ort_ctx.env_memory_info().GetAllocatorType(),
           ort_ctx.env_memory_info().GetMemoryType())),
-      class_names_(std::move(class_names)) {
+      class_names_(std::move(class_names)),
+      output_quant_(output_quant) {
   auto input_info = session_->GetInputTypeInfo(0);
   auto type_and_shape_info = input_info.GetTensorTypeAndShapeInfo();
   auto ele_type = type_and_shape_info.GetElementType();
@@ -267,6 +284,13 @@ InferYOLOOrtImpl::InferYOLOOrtImpl(InferContextORT& ort_ctx,
   output_value_type_ = session_->GetOutputTypeInfo(0)
                            .GetTensorTypeAndShapeInfo()
                            .GetElementType();
+  // 量化模型的输入张量按平面RGB图片访问，预处理直接写入
+  if (IsOrtQuantizedType(input_value_type_))
+    input_tensor_image_ = cv::Mat{
+        input_size_,
+        input_value_type_ == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8 ? CV_8UC3
+                                                                 : CV_8SC3,
+        input_value_.GetTensorMutableRawData()};
 }
 
 YOLOVersion InferYOLOOrtImpl::version() const noexcept { return version_; }
@@ -275,12 +299,27 @@ const std::vector<std::string>& InferYOLOOrtImpl::class_names() const noexcept {
   return class_names_;
 }
 
-InferYOLO::RunResult InferYOLOOrtImpl::Run(
-    const cv::Mat& image, float confidence_threshold) noexcept {
+std::vector<std::string> InferYOLOOrtImpl::EndProfiling() noexcept {
+  std::lock_guard lock{run_mutex_};
+  try {
+    auto path = session_->EndProfilingAllocated(allocator_);
+    if (path && *path.get()) return {std::string{path.get()}};
+  } catch (Ort::Exception& _) {
+  }
+  return {};
+}
+
+InferYOLO::RunResult InferYOLOOrtImpl::Run(const cv::Mat& image,
+                                           float confidence_threshold,
+                                           YOLORunTiming* timing) noexcept {
   // PreProcess
   if (image.rows == 0 || image.cols == 0)
     return std::unexpected(VisionSimpleError{
         VisionSimpleErrorCode::kParameterError, "image is empty"});
+  std::lock_guard lock{run_mutex_};
+  YOLORunTiming unused;
+  auto& stage = timing ? (*timing = YOLORunTiming{}) : unused;
+  StageClock clock{timing != nullptr};
   cv::Mat& chw = PreProcess(image);
   // auto hwc_ptr = hwc.ptr<float>();
   // auto hwc_size = hwc.channels() * hwc.cols * hwc.rows;
@@ -299,7 +338,10 @@ InferYOLO::RunResult InferYOLOOrtImpl::Run(
                 chw.channels() * chw.rows * chw.cols * sizeof(float));
     // std::memcpy(input_value_.GetTensorMutableData<float>(), hwc_ptr,
     // hwc_size_bytes);
-  } else {
+  } else if (input_value_type_ == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8) {
+    // 对应scale=1/255、zero_point=-128的量化，即像素值减128
+    chw.convertTo(input_tensor_image_, CV_8S, 1.0, -128.0);
+  } else if (input_value_type_ != ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8) {
     return std::unexpected(VisionSimpleError{
         VisionSimpleErrorCode::kParameterError,
         std::format("unsupported input value type:{}",
@@ -307,34 +349,29 @@ InferYOLO::RunResult InferYOLOOrtImpl::Run(
   }
   io_binding_.BindInput(input_name_.data(), input_value_);
   io_binding_.BindOutput(output_name_.data(), output_memory_info_);
+  clock.Lap(stage.preprocess_ns);
   Ort::RunOptions run_options;
   session_->Run(run_options, io_binding_);
+  clock.Lap(stage.session_run_ns);
   auto output_values = io_binding_.GetOutputValues();
   auto& output_value = output_values[0];
   // fp16 fp32
   auto output_shape = output_value.GetTensorTypeAndShapeInfo().GetShape();
   auto output_size = std::accumulate(output_shape.begin(), output_shape.end(),
                                      1llu, std::multiplies());
-  // auto output_size_bytes = output_size * sizeof(float);
-  const float* output_data = nullptr;
-  if (output_value_type_ == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16) {
-    if (output_fp32_cache_.size() != output_size)
-      output_fp32_cache_.resize(output_size);
-    auto output_data_mut = output_fp32_cache_.data();
-    output_data = output_data_mut;
-    Cvt::cvt(std::span(output_value.GetConst().GetTensorData<Ort::Float16_t>(),
-                       output_size),
-             output_data_mut);
-  } else if (output_value_type_ == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
-    output_data = output_value.GetConst().GetTensorData<float>();
-  } else {
+  // fp16转换、uint8/int8反量化到output_fp32_cache_，fp32直接使用
+  const float* output_data =
+      OrtTensorAsFloat(output_value, output_quant_, output_fp32_cache_);
+  if (!output_data) {
     return std::unexpected(VisionSimpleError{
         VisionSimpleErrorCode::kParameterError,
         std::format("unsupported output value type:{}",
                     magic_enum::enum_name(output_value_type_))});
   }
+  clock.Lap(stage.output_convert_ns);
   auto result = filter_(std::span(output_data, output_size),
                         confidence_threshold, this->input_size_.width,
-                        this->input_size_.height, image.cols, image.rows);
+                        this->input_size_.height, image.cols, image.rows,
+                        timing);
   return result;
 }
@@ -2,6 +2,7 @@
 #include "../Infer.h"
 #include "InferORT.h"
 #include <magic_enum.hpp>
+#include <mutex>
 #include <opencv2/opencv.hpp>
 
 #include "VisionHelper.hpp"
@@ -25,13 +26,14 @@ namespace vision_simple
 
         YOLOVersion version() const noexcept;
 
-        YOLOFrameResult v11(
+        // v11/v10只负责解码，NMS在operator()中统一处理
+        std::vector<YOLOResult> v11(
             std::span<const float> infer_output,
             float confidence_threshold,
             int img_width, int img_height,
             int orig_width, int orig_height) const noexcept;
 
-        YOLOFrameResult v10(
+        std::vector<YOLOResult> v10(
             std::span<const float> infer_output,
             float confidence_threshold,
             int img_width, int img_height,
@@ -41,7 +43,8 @@ namespace vision_simple
             std::span<const float> infer_output,
             float confidence_threshold,
             int img_width, int img_height,
-            int orig_width, int orig_height) const noexcept;
+            int orig_width, int orig_height,
+            YOLORunTiming* timing = nullptr) const noexcept;
     };
 
 
@@ -58,10 +61,15 @@ namespace vision_simple
         Ort::Value input_value_;
         Ort::MemoryInfo output_memory_info_;
         std::vector<std::string> class_names_;
+        OrtQuantParams output_quant_;
 
         VisionHelper vision_helper_;
         cv::Mat preprocessed_image_;
+        // uint8/int8输入时引用input_value_的数据
+        cv::Mat input_tensor_image_;
         std::vector<float> output_fp32_cache_;
+        // io_binding_、input_value_及上面的缓冲区由每次Run独占
+        std::mutex run_mutex_;
 
     protected:
         cv::Mat& PreProcess(const cv::Mat& image) noexcept;
@@ -71,12 +79,16 @@ namespace vision_simple
                          std::unique_ptr<Ort::Session>&& session,
                          Ort::Allocator&& allocator,
                          YOLOVersion version,
-                         std::vector<std::string> class_names);
+                         std::vector<std::string> class_names,
+                         OrtQuantParams output_quant = {});
 
         YOLOVersion version() const noexcept override;
 
         const std::vector<std::string>& class_names() const noexcept override;
 
-        RunResult Run(const cv::Mat& image, float confidence_threshold) noexcept override;
+        RunResult Run(const cv::Mat& image, float confidence_threshold,
+                      YOLORunTiming* timing = nullptr) noexcept override;
+
+        std::vector<std::string> EndProfiling() noexcept override;
     };
 }
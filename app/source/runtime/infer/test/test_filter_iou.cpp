@@ -0,0 +1,56 @@
+#include <iostream>
+#include <random>
+
+#include "VisionHelper.hpp"
+#include "TestCheck.h"
+using namespace vision_simple;
+
+// 逐对比较的参考实现
+std::vector<cv::Rect> FilterByIOUNaive(const std::vector<cv::Rect>& boxes,
+                                       double threshold,
+                                       VisionHelper::OverlapMetric metric) {
+  std::vector<cv::Rect> kept;
+  for (const auto& box : boxes) {
+    bool keep = true;
+    for (const auto& other : kept) {
+      const double overlap = metric == VisionHelper::OverlapMetric::kIOU
+                                 ? VisionHelper::ComputeIOU(box, other)
+                                 : VisionHelper::ComputeIOS(box, other);
+      if (overlap > threshold) {
+        keep = false;
+        break;
+      }
+    }
+    if (keep) kept.emplace_back(box);
+  }
+  return kept;
+}
+
+int main() {
+  // 交集50，并集150
+  CHECK(VisionHelper::ComputeIOU({0, 0, 10, 10}, {5, 0, 10, 10}) == 1.0 / 3);
+  CHECK(VisionHelper::ComputeIOS({0, 0, 10, 10}, {2, 2, 4, 4}) == 1.0);
+  CHECK(VisionHelper::ComputeIOU({0, 0, 10, 10}, {20, 20, 5, 5}) == 0.0);
+  // 对角相邻的两个框外接矩形很大，但并不重合
+  CHECK(VisionHelper::FilterByIOU({{0, 0, 10, 10}, {9, 9, 10, 10}}, 0.3)
+            .size() == 2);
+
+  std::mt19937 rng{42};
+  for (int round = 0; round < 100; ++round) {
+    const int span = 64 + static_cast<int>(rng() % 2048);
+    std::vector<cv::Rect> boxes(1 + rng() % 500);
+    for (auto& box : boxes) {
+      box = {static_cast<int>(rng() % span), static_cast<int>(rng() % span),
+             1 + static_cast<int>(rng() % 160),
+             1 + static_cast<int>(rng() % 48)};
+      if (rng() % 16 == 0) box.width = 1 + static_cast<int>(rng() % span);
+    }
+    const double threshold = static_cast<double>(rng() % 100) / 100.0;
+    for (auto metric :
+         {VisionHelper::OverlapMetric::kIOU, VisionHelper::OverlapMetric::kIOS})
+      CHECK(VisionHelper::FilterByIOU(boxes, threshold, metric) ==
+            FilterByIOUNaive(boxes, threshold, metric));
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <iostream>
+
+// 条件不成立时打印位置并以-1从main返回
+#define CHECK(cond)                                                 \
+  do {                                                              \
+    if (!(cond)) {                                                  \
+      std::cout << "check failed:" << #cond << " line:" << __LINE__ \
+                << std::endl;                                       \
+      return -1;                                                    \
+    }                                                               \
+  } while (0)
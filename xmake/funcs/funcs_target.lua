@@ -5,6 +5,8 @@ local binary_dirs = {"bin","lib"}
 local binary_suffixes = {"dll","so"}
 local test_root_dirs = {"test"}
 local test_file_prefixes = {"test_"}
+-- headers shared by all tests, e.g. TestCheck.h
+local test_include_dir = path.join("app", "source", "test")
 local header_install_prefix = "vision_simple"
 
 function TargetAddHeaders(base_dir --[[string]])
@@ -65,6 +67,7 @@ function TargetAddTests(target_name --[[string]],base_dir --[[string]],group_nam
                 add_deps(target_name)
             end
             add_files(path.join("test",test_target_filename))
+            add_includedirs(path.join(os.projectdir(),test_include_dir))
             add_tests("default")
             add_rules("auto_cp_deps_assets_configs_to_build")
             after_load(function(target)